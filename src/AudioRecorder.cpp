@@ -0,0 +1,129 @@
+#include "AudioRecorder.h"
+#include "Trace.h"
+#include "ofMain.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+AudioRecorder::~AudioRecorder() {
+    stop();
+}
+
+void AudioRecorder::setup(int sr, int nChannels, float ringSeconds) {
+    stop();
+    sampleRate  = sr;
+    numChannels = nChannels;
+
+    // round up to a power of two so positions can just be masked
+    size_t wanted = (size_t)(ringSeconds * sampleRate) * numChannels;
+    size_t size   = 1;
+    while (size < wanted) size <<= 1;
+    ring.assign(size, 0.0f);
+    ringMask = size - 1;
+
+    // write about half a second per disk write
+    chunk.resize((size_t)(sampleRate / 2) * numChannels);
+}
+
+bool AudioRecorder::start(const std::string& path) {
+    if (ring.empty()) return false;
+    stop();
+
+    if (!wav.open(path, sampleRate, numChannels)) {
+        ofLogError("AudioRecorder") << "couldn't open " << path;
+        return false;
+    }
+
+    // skip anything left in the ring from a push that raced the last stop()
+    readPos.store(writePos.load());
+    overflows     = 0;
+    framesWritten = 0;
+    writeError    = false;
+
+    writerRunning = true;
+    writer = std::thread(&AudioRecorder::writerLoop, this);
+    recording = true;
+
+    ofLogNotice("AudioRecorder") << "recording to " << path;
+    return true;
+}
+
+void AudioRecorder::stop() {
+    if (!writerRunning) return;
+
+    // audio thread stops pushing first, then the writer drains and exits
+    recording     = false;
+    writerRunning = false;
+    if (writer.joinable()) writer.join();
+    wav.close();
+
+    ofLogNotice("AudioRecorder") << "stopped, " << getRecordedSeconds()
+                                 << "s recorded, " << overflows.load() << " overflows";
+}
+
+void AudioRecorder::push(const float* interleaved, int numFrames, int nChannels) {
+    if (!recording.load(std::memory_order_acquire)) return;
+    if (writeError.load(std::memory_order_relaxed)) return;   // nobody's draining the ring
+    if (nChannels != numChannels) {
+        overflows++;
+        return;
+    }
+
+    size_t count = (size_t)numFrames * numChannels;
+    size_t w     = writePos.load(std::memory_order_relaxed);
+    size_t r     = readPos.load(std::memory_order_acquire);
+
+    // drop the whole buffer rather than a partial one so the file stays aligned
+    if (ring.size() - (w - r) < count) {
+        overflows++;
+        return;
+    }
+
+    // copy in at most two pieces around the wrap point
+    size_t start = w & ringMask;
+    size_t first = std::min(count, ring.size() - start);
+    std::memcpy(&ring[start], interleaved, first * sizeof(float));
+    std::memcpy(&ring[0], interleaved + first, (count - first) * sizeof(float));
+
+    writePos.store(w + count, std::memory_order_release);
+}
+
+float AudioRecorder::getRecordedSeconds() const {
+    return (float)framesWritten.load() / sampleRate;
+}
+
+void AudioRecorder::writerLoop() {
+    Trace::setThreadName("recorder");
+    while (true) {
+        bool   running   = writerRunning.load();
+        size_t r         = readPos.load(std::memory_order_relaxed);
+        size_t available = writePos.load(std::memory_order_acquire) - r;
+
+        // wait for a full chunk so writes stay large, unless we're flushing
+        if (available < chunk.size() && running) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            continue;
+        }
+        if (available == 0) break;   // stopped and drained
+
+        size_t count = std::min(available, chunk.size());
+        count -= count % numChannels;
+
+        size_t start = r & ringMask;
+        size_t first = std::min(count, ring.size() - start);
+        std::memcpy(chunk.data(), &ring[start], first * sizeof(float));
+        std::memcpy(chunk.data() + first, &ring[0], (count - first) * sizeof(float));
+        readPos.store(r + count, std::memory_order_release);
+
+        TRACE_SCOPE("AudioRecorder write");
+        bool ok = wav.write(chunk.data(), count);
+        framesWritten = wav.getFramesWritten();
+        if (!ok) {
+            ofLogError("AudioRecorder") << "write failed after " << getRecordedSeconds()
+                                        << "s, recording stopped (disk full?)";
+            writeError = true;
+            break;
+        }
+    }
+    Trace::releaseThread();
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "WavFile.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// records the master output to a WAV file.
+// the audio thread only copies finished buffers into a preallocated
+// single-producer/single-consumer ring, a background thread drains it
+// to disk in big chunks. push() never blocks or allocates - if the
+// writer falls behind the buffer is dropped and counted as an overflow.
+// if a disk write fails (disk full) the writer stops, the file is closed
+// with what was written so far and hasWriteError() says so.
+class AudioRecorder {
+public:
+    ~AudioRecorder();
+
+    // allocates the ring, call before the sound stream starts
+    void setup(int sampleRate, int numChannels, float ringSeconds = 8.0f);
+
+    bool start(const std::string& path);    // main thread
+    void stop();                            // main thread, flushes what's left
+
+    void push(const float* interleaved, int numFrames, int nChannels);  // audio thread
+
+    bool  isRecording() const { return recording.load(); }
+    int   getOverflowCount() const { return overflows.load(); }
+    bool  hasWriteError() const    { return writeError.load(); }
+    float getRecordedSeconds() const;
+
+private:
+    void writerLoop();
+
+    int sampleRate  = 44100;
+    int numChannels = 2;
+
+    std::vector<float>  ring;           // size is a power of two
+    size_t              ringMask = 0;
+    std::atomic<size_t> writePos{0};    // only touched by push()
+    std::atomic<size_t> readPos{0};     // only touched by the writer thread
+
+    std::atomic<bool>     recording{false};
+    std::atomic<bool>     writerRunning{false};
+    std::atomic<int>      overflows{0};
+    std::atomic<bool>     writeError{false};
+    std::atomic<uint64_t> framesWritten{0};
+
+    std::thread        writer;
+    WavWriter          wav;
+    std::vector<float> chunk;           // writer thread scratch
+};
@@ -0,0 +1,247 @@
+#include "ConvolutionReverb.h"
+#include "WavFile.h"
+#include "Simd.h"
+#include "Trace.h"
+#include "ofMain.h"
+#include <algorithm>
+#include <chrono>
+
+static const int MAX_IR_SECONDS = 10;
+
+ConvolutionReverb::~ConvolutionReverb() {
+    close();
+}
+
+bool ConvolutionReverb::load(const std::string& path, int sr) {
+    close();
+
+    std::vector<float> raw;
+    int fileRate = 0, fileChannels = 0;
+    if (!loadWav(path, raw, fileRate, fileChannels) || raw.empty()) {
+        ofLogError("ConvolutionReverb") << "couldn't load impulse response " << path;
+        return false;
+    }
+
+    sampleRate = sr;
+    irChannels = ofMin(fileChannels, 2);    // anything past stereo is ignored
+    int fileFrames = (int)raw.size() / fileChannels;
+
+    // resample to the stream rate, linear is fine for a reverb tail
+    double ratio = (double)fileRate / sampleRate;
+    irLength = ofMin((int)(fileFrames / ratio), MAX_IR_SECONDS * sampleRate);
+    std::vector<float> ir(irChannels * irLength);
+    for (int ch = 0; ch < irChannels; ch++) {
+        for (int i = 0; i < irLength; i++) {
+            double pos  = i * ratio;
+            int    i0   = (int)pos;
+            float  frac = (float)(pos - i0);
+            float  a = raw[i0 * fileChannels + ch];
+            float  b = (i0 + 1 < fileFrames) ? raw[(i0 + 1) * fileChannels + ch] : 0.0f;
+            ir[ch * irLength + i] = a + (b - a) * frac;
+        }
+    }
+
+    // normalize to unit energy so different IRs come out at a similar level
+    float energy = 0.0f;
+    for (int ch = 0; ch < irChannels; ch++) {
+        float e = 0.0f;
+        for (int i = 0; i < irLength; i++) e += ir[ch * irLength + i] * ir[ch * irLength + i];
+        energy = ofMax(energy, e);
+    }
+    if (energy > 0.0f) {
+        float gain = 1.0f / sqrtf(energy);
+        for (float& s : ir) s *= gain;
+    }
+
+    // transform the IR partitions, each zero padded to FFT_SIZE
+    numPartitions = (irLength + PARTITION_SIZE - 1) / PARTITION_SIZE;
+    audioFFT.setup(FFT_SIZE);
+    workerFFT.setup(FFT_SIZE);
+
+    irSpectraRe.assign(irChannels * numPartitions * BIN_STRIDE, 0.0f);
+    irSpectraIm.assign(irChannels * numPartitions * BIN_STRIDE, 0.0f);
+    std::vector<float> block(FFT_SIZE);
+    for (int ch = 0; ch < irChannels; ch++) {
+        for (int part = 0; part < numPartitions; part++) {
+            std::fill(block.begin(), block.end(), 0.0f);
+            int start = part * PARTITION_SIZE;
+            int len   = ofMin(PARTITION_SIZE, irLength - start);
+            std::copy_n(&ir[ch * irLength + start], len, block.begin());
+            audioFFT.forward(block.data(), irRe(ch, part), irIm(ch, part));
+        }
+    }
+
+    // room for every partition plus slack so the audio thread can run a few
+    // blocks ahead of the worker without overwriting spectra it still reads
+    fdlSize = numPartitions + 2 * HEAD_PARTITIONS;
+    fdlSpectraRe.assign(fdlSize * BIN_STRIDE, 0.0f);
+    fdlSpectraIm.assign(fdlSize * BIN_STRIDE, 0.0f);
+
+    window.assign(FFT_SIZE, 0.0f);
+    inputBlock.assign(PARTITION_SIZE, 0.0f);
+    outputBlock.assign(irChannels * PARTITION_SIZE, 0.0f);
+    accRe.assign(BIN_STRIDE, 0.0f);
+    accIm.assign(BIN_STRIDE, 0.0f);
+    timeScratch.assign(FFT_SIZE, 0.0f);
+
+    tailOut.assign(TAIL_SLOTS * irChannels * PARTITION_SIZE, 0.0f);
+    for (auto& ready : tailReady) ready = -1;
+    workerAccRe.assign(BIN_STRIDE, 0.0f);
+    workerAccIm.assign(BIN_STRIDE, 0.0f);
+    workerTime.assign(FFT_SIZE, 0.0f);
+
+    fifoPos      = 0;
+    currentBlock = 0;
+    resetBlock   = 0;
+    blocksPosted = 0;
+    tailMisses   = 0;
+    wasEnabled   = false;
+    loaded       = true;
+
+    if (numPartitions > HEAD_PARTITIONS) {
+        workerRunning = true;
+        worker = std::thread(&ConvolutionReverb::workerLoop, this);
+    }
+
+    ofLogNotice("ConvolutionReverb") << "loaded " << path << ": " << getIRSeconds()
+                                     << "s, " << irChannels << " ch, "
+                                     << numPartitions << " partitions";
+    return true;
+}
+
+void ConvolutionReverb::close() {
+    workerRunning = false;
+    if (worker.joinable()) worker.join();
+    loaded = false;
+}
+
+float ConvolutionReverb::getIRSeconds() const {
+    return (float)irLength / sampleRate;
+}
+
+void ConvolutionReverb::process(float* buffer, int numFrames, int nChannels) {
+    if (!loaded || !enabled.load()) {
+        wasEnabled = false;
+        return;
+    }
+    TRACE_SCOPE("ConvolutionReverb::process");
+    // don't replay whatever was in the delay line last time it was on
+    if (!wasEnabled) {
+        reset();
+        wasEnabled = true;
+    }
+
+    float wet = mix.load();
+    for (int i = 0; i < numFrames; i++) {
+        float* frame = buffer + i * nChannels;
+
+        float in = 0.0f;
+        for (int ch = 0; ch < nChannels; ch++) in += frame[ch];
+        inputBlock[fifoPos] = in / nChannels;
+
+        // output runs one partition behind the input
+        for (int ch = 0; ch < nChannels; ch++) {
+            frame[ch] += wet * outputBlock[(ch % irChannels) * PARTITION_SIZE + fifoPos];
+        }
+
+        if (++fifoPos == PARTITION_SIZE) {
+            processBlock();
+            fifoPos = 0;
+        }
+    }
+}
+
+void ConvolutionReverb::reset() {
+    std::fill(window.begin(), window.end(), 0.0f);
+    std::fill(inputBlock.begin(), inputBlock.end(), 0.0f);
+    std::fill(outputBlock.begin(), outputBlock.end(), 0.0f);
+    fifoPos = 0;
+
+    // the worker may already have tails for the next few blocks, or be busy
+    // on one, all made from the old input. jump past every block it could be
+    // working on so none of those can match again, and treat the delay line
+    // before the jump as silence rather than clearing it under the worker
+    currentBlock += HEAD_PARTITIONS + TAIL_SLOTS;
+    resetBlock.store(currentBlock, std::memory_order_relaxed);
+    for (auto& ready : tailReady) ready.store(-1, std::memory_order_relaxed);
+}
+
+void ConvolutionReverb::processBlock() {
+    int64_t t     = currentBlock;
+    int64_t first = resetBlock.load(std::memory_order_relaxed);
+
+    // overlap-save: transform the last two input blocks into the delay line
+    std::copy(window.begin() + PARTITION_SIZE, window.end(), window.begin());
+    std::copy(inputBlock.begin(), inputBlock.end(), window.begin() + PARTITION_SIZE);
+    audioFFT.forward(window.data(), fdlRe(t), fdlIm(t));
+
+    // head partitions right here
+    int  head    = ofMin(HEAD_PARTITIONS, numPartitions);
+    bool hasTail = numPartitions > HEAD_PARTITIONS && t - first >= HEAD_PARTITIONS;
+    int  slot    = (int)(t % TAIL_SLOTS);
+    bool tailOk  = hasTail && tailReady[slot].load(std::memory_order_acquire) == t;
+    if (hasTail && !tailOk) tailMisses++;
+
+    for (int ch = 0; ch < irChannels; ch++) {
+        std::fill(accRe.begin(), accRe.end(), 0.0f);
+        std::fill(accIm.begin(), accIm.end(), 0.0f);
+        for (int j = 0; j < head && t - j >= first; j++) {
+            Simd::complexMultiplyAccumulate(accRe.data(), accIm.data(),
+                                            fdlRe(t - j), fdlIm(t - j),
+                                            irRe(ch, j), irIm(ch, j), BIN_STRIDE);
+        }
+        audioFFT.inverse(accRe.data(), accIm.data(), timeScratch.data());
+
+        // only the second half is valid linear convolution
+        float* out = &outputBlock[ch * PARTITION_SIZE];
+        std::copy(timeScratch.begin() + PARTITION_SIZE, timeScratch.end(), out);
+
+        if (tailOk) {
+            const float* tail = &tailOut[(slot * irChannels + ch) * PARTITION_SIZE];
+            for (int i = 0; i < PARTITION_SIZE; i++) out[i] += tail[i];
+        }
+    }
+
+    // let the worker start on the tail for block t + HEAD_PARTITIONS
+    blocksPosted.store(t + 1, std::memory_order_release);
+    currentBlock++;
+}
+
+void ConvolutionReverb::workerLoop() {
+    Trace::setThreadName("reverb tail");
+    int64_t next = 0;   // job n computes the tail for block n + HEAD_PARTITIONS
+    while (workerRunning) {
+        int64_t posted = blocksPosted.load(std::memory_order_acquire);
+        if (next >= posted) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        // the audio thread wants block n + HEAD_PARTITIONS once posted gets
+        // there, anything older is already late so skip ahead
+        next = std::max(next, posted - HEAD_PARTITIONS + 1);
+        computeTail(next + HEAD_PARTITIONS);
+        next++;
+    }
+    Trace::releaseThread();
+}
+
+void ConvolutionReverb::computeTail(int64_t target) {
+    TRACE_SCOPE("ConvolutionReverb::computeTail");
+    int     slot  = (int)(target % TAIL_SLOTS);
+    int64_t first = resetBlock.load(std::memory_order_relaxed);   // ordered by blocksPosted
+
+    for (int ch = 0; ch < irChannels; ch++) {
+        std::fill(workerAccRe.begin(), workerAccRe.end(), 0.0f);
+        std::fill(workerAccIm.begin(), workerAccIm.end(), 0.0f);
+        for (int j = HEAD_PARTITIONS; j < numPartitions && target - j >= first; j++) {
+            Simd::complexMultiplyAccumulate(workerAccRe.data(), workerAccIm.data(),
+                                            fdlRe(target - j), fdlIm(target - j),
+                                            irRe(ch, j), irIm(ch, j), BIN_STRIDE);
+        }
+        workerFFT.inverse(workerAccRe.data(), workerAccIm.data(), workerTime.data());
+        std::copy(workerTime.begin() + PARTITION_SIZE, workerTime.end(),
+                  &tailOut[(slot * irChannels + ch) * PARTITION_SIZE]);
+    }
+
+    tailReady[slot].store(target, std::memory_order_release);
+}
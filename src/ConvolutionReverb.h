@@ -0,0 +1,97 @@
+#pragma once
+#include "FFT.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// master bus convolution reverb using uniformly partitioned FFT convolution
+// (overlap-save, frequency domain delay line).
+//
+// the IR is cut into PARTITION_SIZE blocks. the first HEAD_PARTITIONS are
+// convolved on the audio thread, the rest (the tail) on a worker thread.
+// the tail for block t only needs input up to block t - HEAD_PARTITIONS,
+// so the worker gets HEAD_PARTITIONS blocks of time to finish it. if it's
+// ever late that block's tail is skipped and counted in getTailMisses().
+//
+// mono in (sum of the dry channels), mono or stereo IR out.
+// latency is one partition (256 samples).
+class ConvolutionReverb {
+public:
+    ~ConvolutionReverb();
+
+    // loads an IR from WAV and starts the worker. allocates, so call it
+    // before the sound stream starts
+    bool load(const std::string& path, int sampleRate);
+    bool isLoaded() const { return loaded; }
+
+    // adds the wet signal on top of the interleaved dry buffer (audio thread)
+    void process(float* buffer, int numFrames, int nChannels);
+
+    void  setEnabled(bool val) { enabled = val; }
+    bool  isEnabled() const    { return enabled.load(); }
+    void  setMix(float val)    { mix = val; }
+    float getMix() const       { return mix.load(); }
+    int   getTailMisses() const { return tailMisses.load(); }
+    float getIRSeconds() const;
+
+    void close();   // stops the worker
+
+private:
+    static const int PARTITION_SIZE  = 256;
+    static const int FFT_SIZE        = PARTITION_SIZE * 2;
+    static const int NUM_BINS        = FFT_SIZE / 2 + 1;
+    static const int BIN_STRIDE      = (NUM_BINS + 3) & ~3;   // padded for SIMD
+    static const int HEAD_PARTITIONS = 4;
+    static const int TAIL_SLOTS      = HEAD_PARTITIONS + 1;
+
+    void processBlock();
+    void reset();
+    void workerLoop();
+    void computeTail(int64_t target);
+
+    // spectrum pointers
+    float* irRe(int ch, int part)  { return &irSpectraRe[(ch * numPartitions + part) * BIN_STRIDE]; }
+    float* irIm(int ch, int part)  { return &irSpectraIm[(ch * numPartitions + part) * BIN_STRIDE]; }
+    float* fdlRe(int64_t block)    { return &fdlSpectraRe[(block % fdlSize) * BIN_STRIDE]; }
+    float* fdlIm(int64_t block)    { return &fdlSpectraIm[(block % fdlSize) * BIN_STRIDE]; }
+
+    int sampleRate    = 44100;
+    int irChannels    = 1;
+    int irLength      = 0;
+    int numPartitions = 0;
+    int fdlSize       = 0;
+    bool loaded       = false;
+
+    std::vector<float> irSpectraRe, irSpectraIm;     // [channel][partition][bin]
+    std::vector<float> fdlSpectraRe, fdlSpectraIm;   // input spectra, ring of fdlSize blocks
+
+    // audio thread state
+    FFT                audioFFT;
+    std::vector<float> window;                       // last two input blocks
+    std::vector<float> inputBlock;
+    std::vector<float> outputBlock;                  // [channel][PARTITION_SIZE]
+    std::vector<float> accRe, accIm;
+    std::vector<float> timeScratch;
+    int                fifoPos      = 0;
+    int64_t            currentBlock = 0;             // never goes back, the worker keys on it
+    bool               wasEnabled   = false;
+    std::atomic<int64_t> resetBlock{0};              // blocks before this count as silence
+
+    // tail results, written by the worker, read by the audio thread
+    std::vector<float>   tailOut;                    // [slot][channel][PARTITION_SIZE]
+    std::atomic<int64_t> tailReady[TAIL_SLOTS];      // target block each slot holds
+
+    // worker state
+    std::thread          worker;
+    std::atomic<bool>    workerRunning{false};
+    std::atomic<int64_t> blocksPosted{0};            // spectra in the FDL so far
+    FFT                  workerFFT;
+    std::vector<float>   workerAccRe, workerAccIm;
+    std::vector<float>   workerTime;
+
+    std::atomic<bool>  enabled{false};
+    std::atomic<float> mix{0.3f};
+    std::atomic<int>   tailMisses{0};
+};
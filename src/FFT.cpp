@@ -0,0 +1,94 @@
+#include "FFT.h"
+#include <cmath>
+#include <utility>
+
+void FFT::setup(int n) {
+    size = n;
+
+    int bits = 0;
+    while ((1 << bits) < size) bits++;
+
+    bitReverse.resize(size);
+    for (int i = 0; i < size; i++) {
+        int r = 0;
+        for (int b = 0; b < bits; b++) {
+            if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+        }
+        bitReverse[i] = r;
+    }
+
+    const double pi = 3.14159265358979323846;
+    cosTable.resize(size / 2);
+    sinTable.resize(size / 2);
+    for (int i = 0; i < size / 2; i++) {
+        double angle = 2.0 * pi * i / size;
+        cosTable[i] = (float)cos(angle);
+        sinTable[i] = (float)sin(angle);
+    }
+
+    workRe.assign(size, 0.0f);
+    workIm.assign(size, 0.0f);
+}
+
+void FFT::forward(const float* input, float* re, float* im) {
+    for (int i = 0; i < size; i++) {
+        workRe[i] = input[i];
+        workIm[i] = 0.0f;
+    }
+    transform(false);
+
+    // real input -> spectrum is symmetric, only keep the first half
+    for (int k = 0; k <= size / 2; k++) {
+        re[k] = workRe[k];
+        im[k] = workIm[k];
+    }
+}
+
+void FFT::inverse(const float* re, const float* im, float* output) {
+    // rebuild the mirrored half from the conjugates
+    for (int k = 0; k <= size / 2; k++) {
+        workRe[k] = re[k];
+        workIm[k] = im[k];
+    }
+    for (int k = size / 2 + 1; k < size; k++) {
+        workRe[k] =  re[size - k];
+        workIm[k] = -im[size - k];
+    }
+    transform(true);
+
+    float scale = 1.0f / size;
+    for (int i = 0; i < size; i++) {
+        output[i] = workRe[i] * scale;
+    }
+}
+
+void FFT::transform(bool inverse) {
+    for (int i = 0; i < size; i++) {
+        int j = bitReverse[i];
+        if (j > i) {
+            std::swap(workRe[i], workRe[j]);
+            std::swap(workIm[i], workIm[j]);
+        }
+    }
+
+    float sign = inverse ? 1.0f : -1.0f;
+    for (int len = 2; len <= size; len <<= 1) {
+        int half = len / 2;
+        int step = size / len;
+        for (int start = 0; start < size; start += len) {
+            for (int k = 0; k < half; k++) {
+                float wr = cosTable[k * step];
+                float wi = sign * sinTable[k * step];
+
+                int a = start + k;
+                int b = a + half;
+                float tr = workRe[b] * wr - workIm[b] * wi;
+                float ti = workRe[b] * wi + workIm[b] * wr;
+                workRe[b] = workRe[a] - tr;
+                workIm[b] = workIm[a] - ti;
+                workRe[a] += tr;
+                workIm[a] += ti;
+            }
+        }
+    }
+}
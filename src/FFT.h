@@ -0,0 +1,27 @@
+#pragma once
+#include <vector>
+
+// small radix-2 FFT for real signals, spectra are kept split (re[] / im[])
+// so they can be fed straight into the SIMD helpers in Simd.h.
+// each instance has its own scratch space, so use one per thread.
+class FFT {
+public:
+    void setup(int size);            // size must be a power of two
+    int  getSize() const { return size; }
+    int  getNumBins() const { return size / 2 + 1; }
+
+    // size real samples -> size/2+1 complex bins (unscaled)
+    void forward(const float* input, float* re, float* im);
+    // size/2+1 complex bins -> size real samples, scaled by 1/size
+    void inverse(const float* re, const float* im, float* output);
+
+private:
+    void transform(bool inverse);    // in place on workRe/workIm
+
+    int size = 0;
+    std::vector<float> cosTable;
+    std::vector<float> sinTable;
+    std::vector<int>   bitReverse;
+    std::vector<float> workRe;
+    std::vector<float> workIm;
+};
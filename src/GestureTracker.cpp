@@ -1,4 +1,5 @@
 #include "GestureTracker.h"
+#include "Trace.h"
 
 void GestureTracker::setup(int w, int h) {
     camWidth  = w;
@@ -7,6 +8,7 @@ void GestureTracker::setup(int w, int h) {
 
 void GestureTracker::update() {
     if (!enabled) return;
+    TRACE_SCOPE("GestureTracker::update");
 
     // lazy init: start the camera the first time webcam is enabled
     // retries each frame in case macOS permission dialog blocked the first attempt
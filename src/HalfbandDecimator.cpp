@@ -0,0 +1,67 @@
+#include "HalfbandDecimator.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cmath>
+
+HalfbandDecimator::HalfbandDecimator() {
+    // windowed sinc at a quarter of the input rate. only odd offsets from the
+    // center are non-zero: +-1, +-3, ... +-(2 * NUM_TAPS - 1)
+    const double pi = 3.14159265358979323846;
+    int    length = 4 * DELAY - 1;
+    int    center = length / 2;
+    double sum    = 0.0;
+    double taps[NUM_TAPS];
+
+    for (int k = 0; k < NUM_TAPS; k++) {
+        int    offset = 2 * k - (NUM_TAPS - 1);    // -23, -21, ... 23
+        int    n      = center + offset;
+        double sinc   = sin(pi * offset / 2.0) / (pi * offset);
+        double window = 0.42 - 0.5 * cos(2.0 * pi * n / (length - 1))
+                      + 0.08 * cos(4.0 * pi * n / (length - 1));
+        taps[k] = sinc * window;
+        sum += taps[k];
+    }
+
+    // together with the 0.5 center tap this gives unity gain at DC.
+    // taps[] is symmetric so it doesn't matter that the order is reversed
+    for (int k = 0; k < NUM_TAPS; k++) {
+        coeffs[k] = (float)(taps[k] * 0.5 / sum);
+    }
+}
+
+void HalfbandDecimator::setup(int maxOutputFrames) {
+    maxOutput = maxOutputFrames;
+    evens.assign(HISTORY + maxOutput, 0.0f);
+    odds.assign(DELAY + maxOutput, 0.0f);
+}
+
+void HalfbandDecimator::reset() {
+    std::fill(evens.begin(), evens.end(), 0.0f);
+    std::fill(odds.begin(), odds.end(), 0.0f);
+}
+
+void HalfbandDecimator::process(const float* input, int numOutputFrames, float* output) {
+    // bigger than we were set up for - do it in pieces
+    while (numOutputFrames > maxOutput) {
+        process(input, maxOutput, output);
+        input  += maxOutput * 2;
+        output += maxOutput;
+        numOutputFrames -= maxOutput;
+    }
+
+    // split into the two polyphase branches behind their history
+    float* e = evens.data();
+    float* o = odds.data();
+    for (int i = 0; i < numOutputFrames; i++) {
+        e[HISTORY + i] = input[2 * i];
+        o[DELAY + i]   = input[2 * i + 1];
+    }
+
+    for (int i = 0; i < numOutputFrames; i++) {
+        output[i] += Simd::dotProduct(e + i, coeffs, NUM_TAPS) + 0.5f * o[i];
+    }
+
+    // keep the tail as history for the next block
+    std::copy(e + numOutputFrames, e + numOutputFrames + HISTORY, e);
+    std::copy(o + numOutputFrames, o + numOutputFrames + DELAY, o);
+}
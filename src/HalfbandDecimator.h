@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+
+// 2:1 decimator using a half-band FIR, for bringing oversampled audio back
+// down. every other tap of a half-band filter is zero (except the center,
+// which is 0.5), so it splits into two polyphase branches: the even input
+// samples go through NUM_TAPS real coefficients, the odd ones are just
+// delayed and halved. chain two for 4x.
+//
+// 47-tap Blackman windowed design: flat to ~0.19 of the input rate,
+// ~-75dB from ~0.31, so at 2x from 44.1k everything that folds back lands
+// above ~17kHz.
+class HalfbandDecimator {
+public:
+    HalfbandDecimator();
+
+    void setup(int maxOutputFrames);   // allocates, call off the audio thread
+    void reset();                      // clears the filter history
+
+    // reads numOutputFrames * 2 samples from input, ADDS numOutputFrames to output
+    void process(const float* input, int numOutputFrames, float* output);
+
+private:
+    static const int NUM_TAPS = 24;                // non-zero taps, multiple of 4 for SIMD
+    static const int HISTORY  = NUM_TAPS - 1;      // even branch history
+    static const int DELAY    = NUM_TAPS / 2;      // odd branch delay (filter center)
+
+    float coeffs[NUM_TAPS];          // even branch, reversed so it lines up with history
+    std::vector<float> evens;        // HISTORY samples of history + current block
+    std::vector<float> odds;         // DELAY samples of history + current block
+    int maxOutput = 0;
+};
@@ -0,0 +1,273 @@
+#include "InputAnalyzer.h"
+#include "WavFile.h"
+#include "Simd.h"
+#include "Trace.h"
+#include "RealtimeChecker.h"
+#include "ofMain.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// onset tuning
+static const float FLUX_RATIO    = 1.5f;    // flux must beat the recent mean by this much...
+static const float FLUX_DELTA    = 8.0f;    // ...plus this, so steady noise doesn't trigger
+static const float MIN_RMS       = 0.005f;  // ~-46 dBFS, quieter frames never count as onsets
+static const float YIN_THRESHOLD = 0.15f;
+static const float MAX_PITCH     = 2000.0f;
+
+InputAnalyzer::~InputAnalyzer() {
+    close();
+}
+
+void InputAnalyzer::setup(int sr) {
+    close();
+    sampleRate = sr;
+
+    // about a second of input, rounded up to a power of two
+    size_t size = 1;
+    while (size < (size_t)sampleRate) size <<= 1;
+    ring.assign(size, 0.0f);
+    ringMask = size - 1;
+
+    fft.setup(FRAME_SIZE);
+    history.assign(HISTORY_SIZE, 0.0f);
+    frame.assign(FRAME_SIZE, 0.0f);
+    re.assign(fft.getNumBins(), 0.0f);
+    im.assign(fft.getNumBins(), 0.0f);
+    prevMagnitude.assign(fft.getNumBins(), 0.0f);
+    fluxHistory.assign(FLUX_HISTORY, 0.0f);
+    yinDiff.assign(YIN_MAX_LAG, 1.0f);
+
+    const double pi = 3.14159265358979323846;
+    hann.resize(FRAME_SIZE);
+    for (int i = 0; i < FRAME_SIZE; i++) {
+        hann[i] = (float)(0.5 - 0.5 * cos(2.0 * pi * i / FRAME_SIZE));
+    }
+
+    running  = true;
+    analyzer = std::thread(&InputAnalyzer::analysisLoop, this);
+}
+
+void InputAnalyzer::close() {
+    running = false;
+    if (analyzer.joinable()) analyzer.join();
+}
+
+bool InputAnalyzer::setFileSource(const std::string& path) {
+    std::vector<float> raw;
+    int fileRate = 0, fileChannels = 0;
+    if (!loadWav(path, raw, fileRate, fileChannels) || raw.empty()) {
+        ofLogError("InputAnalyzer") << "couldn't load input file " << path;
+        return false;
+    }
+
+    // mono + linear resample to the stream rate
+    int    fileFrames = (int)raw.size() / fileChannels;
+    double ratio      = (double)fileRate / sampleRate;
+    int    frames     = (int)(fileFrames / ratio);
+    std::vector<float> samples(frames);
+    for (int i = 0; i < frames; i++) {
+        double pos  = i * ratio;
+        int    i0   = (int)pos;
+        int    i1   = ofMin(i0 + 1, fileFrames - 1);
+        float  frac = (float)(pos - i0);
+        float  a = 0.0f, b = 0.0f;
+        for (int ch = 0; ch < fileChannels; ch++) {
+            a += raw[i0 * fileChannels + ch];
+            b += raw[i1 * fileChannels + ch];
+        }
+        samples[i] = (a + (b - a) * frac) / fileChannels;
+    }
+
+    // the analysis thread reads fileSamples without a lock, swap it in while it's stopped
+    bool wasRunning = analyzer.joinable();
+    close();
+    fileSamples.swap(samples);
+    filePos    = 0;
+    fileSource = true;
+    if (wasRunning) {
+        running  = true;
+        analyzer = std::thread(&InputAnalyzer::analysisLoop, this);
+    }
+
+    ofLogNotice("InputAnalyzer") << "using " << path << " as input ("
+                                 << (float)frames / sampleRate << "s, looped)";
+    return true;
+}
+
+void InputAnalyzer::audioIn(const float* input, int numFrames, int nChannels) {
+    RealtimeScope realtime;
+    Trace::setThreadName("audio");
+    TRACE_SCOPE("InputAnalyzer::audioIn");
+
+    // the file source is fed by the analysis thread, live input is ignored then
+    if (!running || !enabled.load() || hasFileSource()) return;
+    if (!input || nChannels <= 0) return;
+
+    size_t w = writePos.load(std::memory_order_relaxed);
+    size_t r = readPos.load(std::memory_order_acquire);
+    if (ring.size() - (w - r) < (size_t)numFrames) {
+        overflows++;    // analysis thread is way behind, skip this block
+        return;
+    }
+
+    for (int i = 0; i < numFrames; i++) {
+        float s = 0.0f;
+        for (int ch = 0; ch < nChannels; ch++) s += input[i * nChannels + ch];
+        ring[(w + i) & ringMask] = s / nChannels;
+    }
+    writePos.store(w + numFrames, std::memory_order_release);
+}
+
+bool InputAnalyzer::popOnset(Onset& onset) {
+    int r = queueRead.load(std::memory_order_relaxed);
+    if (r == queueWrite.load(std::memory_order_acquire)) return false;
+    onset = queue[r % QUEUE_SIZE];
+    queueRead.store(r + 1, std::memory_order_release);
+    return true;
+}
+
+void InputAnalyzer::analysisLoop() {
+    Trace::setThreadName("input analysis");
+    std::vector<float> hop(HOP_SIZE);
+
+    // file source: samples owed to the analysis since the last pass
+    double fileDue  = 0.0;
+    auto   lastTime = std::chrono::steady_clock::now();
+
+    while (running) {
+        if (hasFileSource()) {
+            if (readFileHop(hop.data(), fileDue) == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                auto now = std::chrono::steady_clock::now();
+                if (enabled) {
+                    fileDue += std::chrono::duration<double>(now - lastTime).count() * sampleRate;
+                }
+                lastTime = now;
+                continue;
+            }
+            analyzeHop(hop.data());
+            continue;
+        }
+
+        size_t r         = readPos.load(std::memory_order_relaxed);
+        size_t available = writePos.load(std::memory_order_acquire) - r;
+        if (available < HOP_SIZE) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            continue;
+        }
+
+        for (int i = 0; i < HOP_SIZE; i++) {
+            hop[i] = ring[(r + i) & ringMask];
+        }
+        readPos.store(r + HOP_SIZE, std::memory_order_release);
+
+        analyzeHop(hop.data());
+    }
+    Trace::releaseThread();
+}
+
+// next hop of the looped file, once real time has caught up with it.
+// returns the number of samples read (0 or HOP_SIZE)
+int InputAnalyzer::readFileHop(float* hop, double& due) {
+    if (due < HOP_SIZE) return 0;
+    due = ofMin(due - HOP_SIZE, (double)sampleRate);   // don't burst after a stall
+
+    for (int i = 0; i < HOP_SIZE; i++) {
+        hop[i] = fileSamples[filePos];
+        if (++filePos == fileSamples.size()) filePos = 0;
+    }
+    return HOP_SIZE;
+}
+
+void InputAnalyzer::analyzeHop(const float* hop) {
+    TRACE_SCOPE("InputAnalyzer::analyzeHop");
+    hopCount++;
+
+    std::copy(history.begin() + HOP_SIZE, history.end(), history.begin());
+    std::copy(hop, hop + HOP_SIZE, history.end() - HOP_SIZE);
+
+    // windowed spectrum of the newest frame
+    const float* newest = history.data() + HISTORY_SIZE - FRAME_SIZE;
+    float energy = 0.0f;
+    for (int i = 0; i < FRAME_SIZE; i++) {
+        frame[i] = newest[i] * hann[i];
+        energy  += newest[i] * newest[i];
+    }
+    float rms = sqrtf(energy / FRAME_SIZE);
+    fft.forward(frame.data(), re.data(), im.data());
+
+    // spectral flux: how much the log compressed spectrum grew since last hop
+    float flux = 0.0f;
+    for (int k = 0; k < fft.getNumBins(); k++) {
+        float mag = logf(1.0f + sqrtf(re[k] * re[k] + im[k] * im[k]));
+        flux += ofMax(0.0f, mag - prevMagnitude[k]);
+        prevMagnitude[k] = mag;
+    }
+
+    float mean = 0.0f;
+    for (float f : fluxHistory) mean += f;
+    mean /= FLUX_HISTORY;
+    fluxHistory[fluxPos] = flux;
+    fluxPos = (fluxPos + 1) % FLUX_HISTORY;
+
+    // pitch for an earlier onset, now that the attack is out of the window
+    if (pitchCountdown > 0 && --pitchCountdown == 0) {
+        Onset onset = { detectPitch(), pendingStrength };
+
+        int w = queueWrite.load(std::memory_order_relaxed);
+        if (w - queueRead.load(std::memory_order_acquire) < QUEUE_SIZE) {
+            queue[w % QUEUE_SIZE] = onset;
+            queueWrite.store(w + 1, std::memory_order_release);
+        }
+        onsetCount++;
+        if (onset.frequency > 0.0f) lastPitch = onset.frequency;
+    }
+
+    bool onset = rms > MIN_RMS
+              && flux > mean * FLUX_RATIO + FLUX_DELTA
+              && hopCount - lastOnsetHop >= REFRACTORY_HOPS;
+    if (onset) {
+        lastOnsetHop    = hopCount;
+        pitchCountdown  = PITCH_DELAY;
+        pendingStrength = ofMap(20.0f * log10f(rms), -46.0f, -6.0f, 0.1f, 1.0f, true);
+    }
+}
+
+float InputAnalyzer::detectPitch() {
+    TRACE_SCOPE("InputAnalyzer::detectPitch");
+
+    // YIN on the newest YIN_WINDOW + YIN_MAX_LAG samples.
+    // d(tau) = sum (x[j] - x[j + tau])^2 = e(0) + e(tau) - 2 * sum x[j] * x[j + tau]
+    // with the energies kept as running sums and the cross term done with SIMD
+    const float* x = history.data() + HISTORY_SIZE - (YIN_WINDOW + YIN_MAX_LAG);
+
+    float e0 = 0.0f;
+    for (int j = 0; j < YIN_WINDOW; j++) e0 += x[j] * x[j];
+    if (e0 <= 0.0f) return 0.0f;
+
+    float eTau    = e0;
+    float running = 0.0f;
+    yinDiff[0] = 1.0f;
+    for (int tau = 1; tau < YIN_MAX_LAG; tau++) {
+        eTau += x[tau + YIN_WINDOW - 1] * x[tau + YIN_WINDOW - 1] - x[tau - 1] * x[tau - 1];
+        float d = ofMax(0.0f, e0 + eTau - 2.0f * Simd::dotProduct(x, x + tau, YIN_WINDOW));
+        running += d;
+        // cumulative mean normalized difference
+        yinDiff[tau] = running > 0.0f ? d * tau / running : 1.0f;
+    }
+
+    // first dip under the threshold, walked down to its minimum
+    int minLag = ofMax(2, (int)(sampleRate / MAX_PITCH));
+    for (int tau = minLag; tau < YIN_MAX_LAG - 1; tau++) {
+        if (yinDiff[tau] >= YIN_THRESHOLD) continue;
+        while (tau + 1 < YIN_MAX_LAG - 1 && yinDiff[tau + 1] < yinDiff[tau]) tau++;
+
+        // parabolic interpolation between lags
+        float a = yinDiff[tau - 1], b = yinDiff[tau], c = yinDiff[tau + 1];
+        float denom = a - 2.0f * b + c;
+        float shift = (denom != 0.0f) ? ofClamp(0.5f * (a - c) / denom, -1.0f, 1.0f) : 0.0f;
+        return sampleRate / (tau + shift);
+    }
+    return 0.0f;    // noisy or unpitched
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include "FFT.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// listens to the audio input and reports note onsets with their pitch,
+// so a live instrument can play the particle field.
+//
+// the audio thread only copies the (mono) input into a lock-free ring.
+// a separate analysis thread runs, every HOP_SIZE samples:
+//  - onset detection: spectral flux of the log magnitude spectrum against
+//    an adaptive threshold (mean of the recent flux)
+//  - pitch: YIN on the frames just after an onset, once the attack settles
+// onsets go into a small lock-free queue that ofApp drains in update(),
+// about PITCH_DELAY hops (~23ms at 44.1k) after they happen.
+//
+// a WAV file can stand in for the microphone (setFileSource), handy for
+// testing without an instrument. the analysis thread reads it at real-time
+// pace itself, so it works without any input device.
+class InputAnalyzer {
+public:
+    struct Onset {
+        float frequency;    // Hz, 0 if there was no clear pitch
+        float strength;     // 0-1, from the input level
+    };
+
+    ~InputAnalyzer();
+
+    void setup(int sampleRate);     // allocates and starts the analysis thread
+    void close();
+
+    // loops the file instead of the live input. call after setup (it needs the
+    // sample rate), it restarts the analysis thread to swap the file in
+    bool setFileSource(const std::string& path);
+    bool hasFileSource() const { return fileSource.load(); }
+
+    void audioIn(const float* input, int numFrames, int nChannels);   // audio thread
+
+    bool popOnset(Onset& onset);    // main thread, false when there's nothing new
+
+    void  setEnabled(bool val) { enabled = val; }
+    bool  isEnabled() const    { return enabled.load(); }
+    int   getOnsetCount() const    { return onsetCount.load(); }
+    float getLastPitch() const     { return lastPitch.load(); }
+    int   getOverflowCount() const { return overflows.load(); }
+
+private:
+    static const int HOP_SIZE        = 256;     // ~6ms at 44.1k
+    static const int FRAME_SIZE      = 1024;    // onset FFT
+    static const int YIN_WINDOW      = 512;
+    static const int YIN_MAX_LAG     = 640;     // lowest pitch = sampleRate / YIN_MAX_LAG (~69Hz)
+    static const int HISTORY_SIZE    = YIN_WINDOW + YIN_MAX_LAG;    // >= FRAME_SIZE
+    static const int FLUX_HISTORY    = 16;      // hops averaged for the threshold
+    static const int REFRACTORY_HOPS = 10;      // min ~60ms between onsets
+    static const int PITCH_DELAY     = 4;       // hops to wait before tracking pitch,
+                                                // so the YIN window is past the attack
+    static const int QUEUE_SIZE      = 64;
+
+    void  analysisLoop();
+    void  analyzeHop(const float* hop);
+    int   readFileHop(float* hop, double& due);
+    float detectPitch();
+
+    int sampleRate = 44100;
+
+    // audio thread -> analysis thread
+    std::vector<float>  ring;
+    size_t              ringMask = 0;
+    std::atomic<size_t> writePos{0};
+    std::atomic<size_t> readPos{0};
+
+    // file source, read by the analysis thread only. only changed while
+    // that thread is stopped, the flag is what everyone else checks
+    std::vector<float> fileSamples;     // mono, at sampleRate
+    size_t             filePos = 0;
+    std::atomic<bool>  fileSource{false};
+
+    // analysis thread state
+    FFT                fft;
+    std::vector<float> history;         // newest sample last
+    std::vector<float> hann;
+    std::vector<float> frame, re, im;
+    std::vector<float> prevMagnitude;
+    std::vector<float> fluxHistory;
+    std::vector<float> yinDiff;
+    int                fluxPos       = 0;
+    int64_t            hopCount      = 0;
+    int64_t            lastOnsetHop  = -REFRACTORY_HOPS;
+    int                pitchCountdown  = 0;
+    float              pendingStrength = 0.0f;
+
+    // analysis thread -> main thread
+    Onset               queue[QUEUE_SIZE];
+    std::atomic<int>    queueWrite{0};
+    std::atomic<int>    queueRead{0};
+
+    std::thread        analyzer;
+    std::atomic<bool>  running{false};
+    std::atomic<bool>  enabled{false};
+    std::atomic<int>   onsetCount{0};
+    std::atomic<float> lastPitch{0.0f};
+    std::atomic<int>   overflows{0};
+};
@@ -1,5 +1,25 @@
 #include "Oscillator.h"
 
+// shared render loop, with the waveform passed in so it gets inlined
+template <typename Shape>
+static void renderShape(Shape shape, float* out, int numSamples, float& phase,
+                        float inc, float amplitude, float ampStep) {
+    float p = phase;
+    for (int i = 0; i < numSamples; i++) {
+        amplitude += ampStep;
+        out[i] += shape(p) * amplitude;
+        p += inc;
+        if (p >= 1.0f) p -= 1.0f;
+    }
+    phase = p;
+}
+
+void Oscillator::render(float* out, int numSamples, float& phase, float inc,
+                        float amplitude, float ampStep) {
+    renderShape([this](float p) { return getSample(p); },
+                out, numSamples, phase, inc, amplitude, ampStep);
+}
+
 float SineOscillator::getSample(float phase) {
     return sin(phase * TWO_PI);
 }
@@ -13,5 +33,41 @@ float SawOscillator::getSample(float phase) {
 }
 
 float NoiseOscillator::getSample(float phase) {
-    return ofRandom(-1.0f, 1.0f);
+    // own xorshift instead of ofRandom, which shares its generator
+    // with the main thread and isn't safe to call from the audio callback
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed * (2.0f / 4294967295.0f) - 1.0f;
+}
+
+void SineOscillator::render(float* out, int numSamples, float& phase, float inc,
+                            float amplitude, float ampStep) {
+    renderShape([](float p) { return sinf(p * (float)TWO_PI); },
+                out, numSamples, phase, inc, amplitude, ampStep);
+}
+
+void SquareOscillator::render(float* out, int numSamples, float& phase, float inc,
+                              float amplitude, float ampStep) {
+    renderShape([](float p) { return p < 0.5f ? 1.0f : -1.0f; },
+                out, numSamples, phase, inc, amplitude, ampStep);
+}
+
+void SawOscillator::render(float* out, int numSamples, float& phase, float inc,
+                           float amplitude, float ampStep) {
+    renderShape([](float p) { return 2.0f * p - 1.0f; },
+                out, numSamples, phase, inc, amplitude, ampStep);
+}
+
+void NoiseOscillator::render(float* out, int numSamples, float& phase, float inc,
+                             float amplitude, float ampStep) {
+    uint32_t s = seed;
+    renderShape([&s](float) {
+                    s ^= s << 13;
+                    s ^= s >> 17;
+                    s ^= s << 5;
+                    return s * (2.0f / 4294967295.0f) - 1.0f;
+                },
+                out, numSamples, phase, inc, amplitude, ampStep);
+    seed = s;
 }
@@ -9,28 +9,45 @@ public:
     virtual ~Oscillator() = default;
     virtual float getSample(float phase) = 0;  // phase in [0,1), returns [-1,1]
     virtual std::string getName() = 0;
+
+    // adds numSamples of the waveform into out, advancing phase by inc per
+    // sample while the amplitude ramps by ampStep. this is the inner loop of
+    // the mix, so each waveform overrides it with its shape inlined
+    virtual void render(float* out, int numSamples, float& phase, float inc,
+                        float amplitude, float ampStep);
 };
 
 class SineOscillator : public Oscillator {
 public:
     float getSample(float phase) override;
+    void  render(float* out, int numSamples, float& phase, float inc,
+                 float amplitude, float ampStep) override;
     std::string getName() override { return "Sine"; }
 };
 
 class SquareOscillator : public Oscillator {
 public:
     float getSample(float phase) override;
+    void  render(float* out, int numSamples, float& phase, float inc,
+                 float amplitude, float ampStep) override;
     std::string getName() override { return "Square"; }
 };
 
 class SawOscillator : public Oscillator {
 public:
     float getSample(float phase) override;
+    void  render(float* out, int numSamples, float& phase, float inc,
+                 float amplitude, float ampStep) override;
     std::string getName() override { return "Saw"; }
 };
 
 class NoiseOscillator : public Oscillator {
 public:
     float getSample(float phase) override;
+    void  render(float* out, int numSamples, float& phase, float inc,
+                 float amplitude, float ampStep) override;
     std::string getName() override { return "Noise"; }
+
+private:
+    uint32_t seed = 22222;  // xorshift state
 };
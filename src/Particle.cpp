@@ -7,7 +7,6 @@ Particle::Particle(glm::vec2 pos, OscType type, float freq, float amp, float lif
     , oscType(type)
     , frequency(freq)
     , amplitude(amp)
-    , phase(0.0f)
     , lifetime(life)
     , age(0.0f)
 {
@@ -52,33 +51,60 @@ void Particle::update(float dt) {
     radius = ofMax(1.0f, radius - dt * 1.5f);
 }
 
-void Particle::draw() {
+// filled circle as triangles around its center. segments must divide CIRCLE_SEGMENTS
+static const int CIRCLE_SEGMENTS = 24;
+
+static void addDisc(ofMesh& mesh, glm::vec2 center, float r, const ofColor& c, int segments) {
+    // unit circle, worked out once
+    static const std::vector<glm::vec2> unitCircle = [] {
+        std::vector<glm::vec2> points(CIRCLE_SEGMENTS);
+        for (int i = 0; i < CIRCLE_SEGMENTS; i++) {
+            float angle = TWO_PI * i / CIRCLE_SEGMENTS;
+            points[i] = glm::vec2(cos(angle), sin(angle));
+        }
+        return points;
+    }();
+
+    ofFloatColor color(c);
+    ofIndexType  first = (ofIndexType)mesh.getNumVertices();
+    mesh.addVertex(glm::vec3(center.x, center.y, 0));
+    mesh.addColor(color);
+
+    int stride = CIRCLE_SEGMENTS / segments;
+    for (int i = 0; i < segments; i++) {
+        const glm::vec2& p = unitCircle[i * stride];
+        mesh.addVertex(glm::vec3(center.x + p.x * r, center.y + p.y * r, 0));
+        mesh.addColor(color);
+        mesh.addIndex(first);
+        mesh.addIndex(first + 1 + i);
+        mesh.addIndex(first + 1 + (i + 1) % segments);
+    }
+}
+
+void Particle::draw(ofMesh& mesh, bool detailed) const {
     float alpha = getCurrentAmplitude() * 255;
 
+    // big crowds (voice merging) only get a coarse main circle, the
+    // mesh would run to hundreds of MB otherwise
+    if (!detailed) {
+        addDisc(mesh, position, radius, ofColor(color, (int)alpha), 6);
+        return;
+    }
+
     // glow
-    ofSetColor(color, (int)(alpha * 0.25f));
-    ofDrawCircle(position, radius * 2.5f);
+    addDisc(mesh, position, radius * 2.5f, ofColor(color, (int)(alpha * 0.25f)), CIRCLE_SEGMENTS);
 
     // main circle
-    ofSetColor(color, (int)alpha);
-    ofDrawCircle(position, radius);
+    addDisc(mesh, position, radius, ofColor(color, (int)alpha), CIRCLE_SEGMENTS);
 
     // bright center
-    ofSetColor(255, (int)(alpha * 0.6f));
-    ofDrawCircle(position, radius * 0.35f);
+    addDisc(mesh, position, radius * 0.35f, ofColor(255, 255, 255, (int)(alpha * 0.6f)), CIRCLE_SEGMENTS);
 }
 
 bool Particle::isDead() const {
     return age >= lifetime;
 }
 
-float Particle::getNextSample(Oscillator* osc, float sampleRate) {
-    float sample = osc->getSample(phase) * getCurrentAmplitude();
-    phase += frequency / sampleRate;
-    if (phase >= 1.0f) phase -= 1.0f;
-    return sample;
-}
-
 float Particle::getCurrentAmplitude() const {
     float env = 1.0f - (age / lifetime);    // fade out
     env = ofClamp(env, 0.0f, 1.0f);
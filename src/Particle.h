@@ -17,15 +17,14 @@ public:
     OscType oscType;
     float   frequency;
     float   amplitude;
-    float   phase;     // [0, 1), advances per audio sample
+    int     voiceSlot = -1;   // voice it plays on, set by ParticleSystem
 
     Particle(glm::vec2 pos, OscType type, float freq,
              float amp = 0.5f, float life = 3.0f);
 
     void  update(float dt);
-    void  draw();
+    void  draw(ofMesh& mesh, bool detailed) const;   // adds its circles to the batch
     bool  isDead() const;
 
-    float getNextSample(Oscillator* osc, float sampleRate);
     float getCurrentAmplitude() const;
 };
@@ -1,85 +1,282 @@
 #include "ParticleSystem.h"
+#include "Trace.h"
 #include <algorithm>
 
 ParticleSystem::ParticleSystem() {
     // create one oscillator per waveform type
-    oscillators.resize(static_cast<int>(OscType::COUNT));
+    oscillators.resize(NUM_TYPES);
     oscillators[static_cast<int>(OscType::SINE)]   = std::make_unique<SineOscillator>();
     oscillators[static_cast<int>(OscType::SQUARE)] = std::make_unique<SquareOscillator>();
     oscillators[static_cast<int>(OscType::SAW)]    = std::make_unique<SawOscillator>();
     oscillators[static_cast<int>(OscType::NOISE)]  = std::make_unique<NoiseOscillator>();
+
+    particleSlotUsed.assign(MAX_PARTICLES, false);
+    binAmplitude.assign(MAX_VOICES, 0.0f);
+    binFreqSum.assign(MAX_VOICES, 0.0f);
+    mesh.setMode(OF_PRIMITIVE_TRIANGLES);
+
+    for (auto& snap : snapshots) {
+        snap.voices.resize(MAX_VOICES);
+    }
+    voiceStates.resize(MAX_VOICES);
+
+    mixBuffer.resize(MAX_BLOCK, 0.0f);
+    mixBuffer2x.resize(MAX_BLOCK * 2, 0.0f);
+    mixBuffer4x.resize(MAX_BLOCK * 4, 0.0f);
+    decimate2x.setup(MAX_BLOCK);
+    decimate4x.setup(MAX_BLOCK * 2);
 }
 
 void ParticleSystem::spawn(glm::vec2 position, OscType type,
                            float frequency, float amplitude, float lifetime) {
-    std::lock_guard<std::mutex> lock(mutex);
-
-    if ((int)particles.size() >= MAX_PARTICLES) {
-        particles.erase(particles.begin()); // drop oldest
+    int maxParticles = aggregate ? MAX_AGGREGATED_PARTICLES : MAX_PARTICLES;
+    int slot = -1;
+    if ((int)particles.size() >= maxParticles) {
+        slot = particles.front().voiceSlot;   // drop oldest, the new one takes its voice
+        particles.pop_front();
     }
+
     particles.emplace_back(position, type, frequency, amplitude, lifetime);
+    if (aggregate) {
+        slot = voiceSlotFor(type, frequency);
+    } else if (slot < 0) {
+        slot = claimParticleSlot();
+    }
+    particles.back().voiceSlot = slot;
 }
 
 void ParticleSystem::update() {
-    std::lock_guard<std::mutex> lock(mutex);
-    float dt = ofGetLastFrameTime();
+    update(ofGetLastFrameTime());
+}
 
+void ParticleSystem::update(float dt) {
+    TRACE_SCOPE("ParticleSystem::update");
     for (auto& p : particles) {
         p.update(dt);
     }
 
-    // remove dead ones
-    particles.erase(
-        std::remove_if(particles.begin(), particles.end(),
-                       [](const Particle& p) { return p.isDead(); }),
-        particles.end());
+    // free the voices of the dead ones before removing them, remove_if
+    // leaves whatever it likes past the new end
+    if (!aggregate) {
+        for (const auto& p : particles) {
+            if (p.isDead()) particleSlotUsed[p.voiceSlot] = false;
+        }
+    }
+    particles.erase(std::remove_if(particles.begin(), particles.end(),
+                                   [](const Particle& p) { return p.isDead(); }),
+                    particles.end());
+
+    publish();
 }
 
 void ParticleSystem::draw() {
-    std::lock_guard<std::mutex> lock(mutex);
+    TRACE_SCOPE("ParticleSystem::draw");
+    mesh.clear();
+    bool detailed = particles.size() <= DETAILED_DRAW_LIMIT;
+    for (const auto& p : particles) {
+        p.draw(mesh, detailed);
+    }
     ofEnableAlphaBlending();
-    for (auto& p : particles) {
-        p.draw();
+    mesh.draw();
+}
+
+void ParticleSystem::publish() {
+    TRACE_SCOPE("ParticleSystem::publish");
+    Snapshot& snap = snapshots[writeIndex];
+    snap.aggregate     = aggregate;
+    snap.particleCount = (int)particles.size();
+    std::copy(oversampling, oversampling + NUM_TYPES, snap.oversampling);
+
+    int count = 0;
+    if (aggregate) {
+        // gather: sum each particle's current amplitude into its voice
+        for (const auto& p : particles) {
+            float amp = p.getCurrentAmplitude();
+            binAmplitude[p.voiceSlot] += amp;
+            binFreqSum[p.voiceSlot]   += amp * p.frequency;
+        }
+        for (int slot = 0; slot < MAX_VOICES; slot++) {
+            float amp = binAmplitude[slot];
+            if (amp > 0.0f) {
+                OscType type = static_cast<OscType>(slot / BINS_PER_TYPE);
+                // amplitude weighted mean pitch
+                snap.voices[count++] = { slot, type, binFreqSum[slot] / amp, amp };
+            }
+            binAmplitude[slot] = 0.0f;
+            binFreqSum[slot]   = 0.0f;
+        }
+    } else {
+        for (const auto& p : particles) {
+            snap.voices[count++] = { p.voiceSlot, p.oscType, p.frequency,
+                                     p.getCurrentAmplitude() };
+        }
     }
+    snap.numVoices = count;
+
+    writeIndex = latest.exchange(writeIndex | FRESH) & ~FRESH;
 }
 
 void ParticleSystem::fillBuffer(float* output, int bufferSize,
                                 int nChannels, float sampleRate) {
-    std::lock_guard<std::mutex> lock(mutex);
+    TRACE_SCOPE("ParticleSystem::fillBuffer");
+
+    // pick up the newest snapshot if update() published one since last time
+    if (latest.load() & FRESH) {
+        readIndex = latest.exchange(readIndex) & ~FRESH;
+    }
+    const Snapshot& snap = snapshots[readIndex];
+    bufferCount++;
+
+    // switching modes reuses the slots for something else, start them from silence
+    if (snap.aggregate != audioAggregate) {
+        std::fill(voiceStates.begin(), voiceStates.end(), VoiceState());
+        audioAggregate = snap.aggregate;
+    }
 
     // clear
     for (int i = 0; i < bufferSize * nChannels; i++) {
         output[i] = 0.0f;
     }
 
-    if (particles.empty()) return;
+    if (snap.numVoices == 0) {
+        voiceCount = 0;
+        return;
+    }
 
-    // mix all particles together
-    for (auto& p : particles) {
-        Oscillator* osc = oscillators[static_cast<int>(p.oscType)].get();
-        for (int i = 0; i < bufferSize; i++) {
-            float sample = p.getNextSample(osc, sampleRate);
+    // normalize + clip so it doesn't blow out the speakers
+    float scale = 1.0f / ofMax(1.0f, (float)snap.particleCount * 0.5f);
+    float masterVol = 0.4f;
+
+    // which oversampled mixes are in use. a decimator that's just been
+    // switched on starts from a clean history instead of whatever it had
+    bool use4x = false, use2x = false;
+    for (int factor : snap.oversampling) {
+        use4x = use4x || factor == 4;
+        use2x = use2x || factor >= 2;
+    }
+    if (use2x && !decimating2x) decimate2x.reset();
+    if (use4x && !decimating4x) decimate4x.reset();
+    decimating2x = use2x;
+    decimating4x = use4x;
+
+    // mix in mono (every particle is centered anyway), then copy to all channels
+    for (int start = 0; start < bufferSize; start += MAX_BLOCK) {
+        int frames = ofMin(MAX_BLOCK, bufferSize - start);
+        float* mix = mixBuffer.data();
+        std::fill(mix, mix + frames, 0.0f);
+        if (use2x) std::fill(mixBuffer2x.begin(), mixBuffer2x.begin() + frames * 2, 0.0f);
+        if (use4x) std::fill(mixBuffer4x.begin(), mixBuffer4x.begin() + frames * 4, 0.0f);
+
+        mixVoices(snap, frames, sampleRate);
+
+        // 4x -> 2x -> 1x
+        if (use4x) decimate4x.process(mixBuffer4x.data(), frames * 2, mixBuffer2x.data());
+        if (use2x) decimate2x.process(mixBuffer2x.data(), frames, mix);
+
+        for (int i = 0; i < frames; i++) {
+            float sample = ofClamp(mix[i] * scale * masterVol, -1.0f, 1.0f);
             for (int ch = 0; ch < nChannels; ch++) {
-                output[i * nChannels + ch] += sample;
+                output[(start + i) * nChannels + ch] = sample;
             }
         }
     }
+}
 
-    // normalize + clip so it doesn't blow out the speakers
-    float scale = 1.0f / ofMax(1.0f, (float)particles.size() * 0.5f);
-    float masterVol = 0.4f;
-    for (int i = 0; i < bufferSize * nChannels; i++) {
-        output[i] *= scale * masterVol;
-        output[i] = ofClamp(output[i], -1.0f, 1.0f);
+float* ParticleSystem::mixBufferFor(int factor) {
+    switch (factor) {
+        case 4:  return mixBuffer4x.data();
+        case 2:  return mixBuffer2x.data();
+        default: return mixBuffer.data();
+    }
+}
+
+void ParticleSystem::mixVoices(const Snapshot& snap, int numFrames, float sampleRate) {
+    // amplitude ramps linearly to the new target over the block so particles
+    // appearing, fading or sharing a voice don't click. a voice that wasn't in
+    // the last buffer's snapshot (particle died, bin emptied, cleared) starts
+    // again from silence
+    for (int i = 0; i < snap.numVoices; i++) {
+        const VoiceTarget& t = snap.voices[i];
+        VoiceState&        v = voiceStates[t.slot];
+        if (v.lastBuffer + 1 < bufferCount) v.amplitude = 0.0f;
+        v.lastBuffer = bufferCount;
+
+        Oscillator* osc     = oscillators[static_cast<int>(t.type)].get();
+        int         factor  = snap.oversampling[static_cast<int>(t.type)];
+        int         samples = numFrames * factor;
+        float       inc     = t.frequency / (sampleRate * factor);
+        float       step    = (t.amplitude - v.amplitude) / samples;
+
+        osc->render(mixBufferFor(factor), samples, v.phase, inc, v.amplitude, step);
+        v.amplitude = t.amplitude;   // no float drift left over from the ramp
+    }
+    voiceCount = snap.numVoices;
+}
+
+int ParticleSystem::voiceSlotFor(OscType type, float frequency) const {
+    int base = static_cast<int>(type) * BINS_PER_TYPE;
+
+    // noise has no pitch, so it all collapses into one voice
+    if (type == OscType::NOISE) return base;
+
+    float cents = 1200.0f * log2f(ofMax(frequency, LOWEST_FREQ) / LOWEST_FREQ);
+    int bin = (int)(cents / AGGREGATE_CENTS + 0.5f);
+    return base + ofClamp(bin, 0, BINS_PER_TYPE - 1);
+}
+
+// one voice per particle when not aggregating. the cap keeps it under MAX_PARTICLES
+int ParticleSystem::claimParticleSlot() {
+    for (int slot = 0; slot < MAX_PARTICLES; slot++) {
+        if (!particleSlotUsed[slot]) {
+            particleSlotUsed[slot] = true;
+            return slot;
+        }
+    }
+    return 0;
+}
+
+void ParticleSystem::assignVoiceSlots() {
+    std::fill(particleSlotUsed.begin(), particleSlotUsed.end(), false);
+    for (auto& p : particles) {
+        p.voiceSlot = aggregate ? voiceSlotFor(p.oscType, p.frequency) : claimParticleSlot();
+    }
+}
+
+bool ParticleSystem::voiceSlotsAreUnique() const {
+    if (aggregate) return true;   // merged voices share slots on purpose
+
+    std::vector<bool> seen(MAX_PARTICLES, false);
+    for (const auto& p : particles) {
+        if (p.voiceSlot < 0 || p.voiceSlot >= MAX_PARTICLES || seen[p.voiceSlot]) return false;
+        seen[p.voiceSlot] = true;
     }
+    return seen == particleSlotUsed;
+}
+
+int ParticleSystem::getMaxParticles() const {
+    return aggregate ? MAX_AGGREGATED_PARTICLES : MAX_PARTICLES;
+}
+
+void ParticleSystem::setVoiceAggregation(bool enabled) {
+    if (enabled == aggregate) return;
+    aggregate = enabled;
+
+    // back to one oscillator per particle - keep only the newest ones
+    if (!aggregate && (int)particles.size() > MAX_PARTICLES) {
+        particles.erase(particles.begin(), particles.end() - MAX_PARTICLES);
+    }
+    assignVoiceSlots();
+}
+
+void ParticleSystem::setOversampling(OscType type, int factor) {
+    oversampling[static_cast<int>(type)] = (factor >= 4) ? 4 : (factor >= 2) ? 2 : 1;
 }
 
-int ParticleSystem::getParticleCount() const {
-    std::lock_guard<std::mutex> lock(mutex);
-    return (int)particles.size();
+int ParticleSystem::getOversampling(OscType type) const {
+    return oversampling[static_cast<int>(type)];
 }
 
 void ParticleSystem::clear() {
-    std::lock_guard<std::mutex> lock(mutex);
     particles.clear();
+    std::fill(particleSlotUsed.begin(), particleSlotUsed.end(), false);
 }
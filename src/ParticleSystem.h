@@ -2,32 +2,132 @@
 #include "ofMain.h"
 #include "Particle.h"
 #include "Oscillator.h"
-#include <mutex>
+#include "HalfbandDecimator.h"
+#include <atomic>
+#include <deque>
 #include <vector>
 #include <memory>
 
 // manages all active particles + handles audio mixing
-// uses a mutex because fillBuffer() runs on the audio thread
+//
+// the particles belong to the main thread (spawn/update/draw). every update()
+// publishes a snapshot of what should be sounding - one frequency + target
+// amplitude per voice - through a lock-free triple buffer, and fillBuffer()
+// renders the newest snapshot. so the audio thread never waits on the main
+// thread and never touches the particle list, however many particles there are
 class ParticleSystem {
 public:
     ParticleSystem();
 
+    // main thread
     void spawn(glm::vec2 position, OscType type, float frequency,
                float amplitude = 0.5f, float lifetime = 3.0f);
 
-    void update();
+    void update();   // also publishes the snapshot for the audio thread
+    void update(float dt);   // same with a fixed time step, for headless runs
     void draw();
 
-    // mixes all living particles into the output buffer (called from audio thread)
+    // mixes the voices of the last snapshot into the output buffer (called from audio thread)
     void fillBuffer(float* output, int bufferSize, int nChannels, float sampleRate);
 
-    int  getParticleCount() const;
+    int  getParticleCount() const { return (int)particles.size(); }
+    int  getMaxParticles() const;
     void clear();
 
+    // sanity check for tests: without aggregation every particle has a voice
+    // slot of its own and exactly those slots are marked used
+    bool voiceSlotsAreUnique() const;
+
+    // aggregation mode: particles of the same osc type within a few cents of
+    // each other share one oscillator, so audio cost follows the number of
+    // distinct pitches instead of the number of particles
+    void setVoiceAggregation(bool enabled);
+    bool isVoiceAggregationEnabled() const { return aggregate; }
+    int  getVoiceCount() const { return voiceCount.load(); }   // oscillators rendered last buffer
+
+    // render one osc type at 2x or 4x the output rate to cut aliasing
+    // (1 = off). oversampled voices are mixed at their rate and brought back
+    // down by half-band decimators, so only the types that alias pay for it
+    void setOversampling(OscType type, int factor);
+    int  getOversampling(OscType type) const;
+
 private:
-    std::vector<Particle> particles;
+    static const int NUM_TYPES = static_cast<int>(OscType::COUNT);
+
+    // what the audio thread should play on one voice
+    struct VoiceTarget {
+        int     slot;
+        OscType type;
+        float   frequency;
+        float   amplitude;
+    };
+
+    struct Snapshot {
+        std::vector<VoiceTarget> voices;    // preallocated to MAX_VOICES
+        int  numVoices     = 0;
+        int  particleCount = 0;             // for the mix normalization
+        bool aggregate     = false;
+        int  oversampling[NUM_TYPES] = { 1, 1, 1, 1 };
+    };
+
+    // audio thread side of a voice
+    struct VoiceState {
+        float    phase      = 0.0f;
+        float    amplitude  = 0.0f;         // ramps towards the target every buffer
+        uint64_t lastBuffer = 0;            // last buffer it played in
+    };
+
+    int    voiceSlotFor(OscType type, float frequency) const;
+    int    claimParticleSlot();
+    void   assignVoiceSlots();
+    void   publish();
+    void   mixVoices(const Snapshot& snap, int numFrames, float sampleRate);
+    float* mixBufferFor(int factor);
+
+    // main thread
+    std::deque<Particle> particles;          // oldest first, so the cap drops from the front
+    bool                 aggregate = false;
+    int                  oversampling[NUM_TYPES] = { 1, 1, 1, 1 };
+    std::vector<bool>    particleSlotUsed;   // per-particle voices in use (MAX_PARTICLES)
+    std::vector<float>   binAmplitude;       // aggregation gather, one per voice slot
+    std::vector<float>   binFreqSum;
+    ofMesh               mesh;               // every particle drawn in one batch
+
+    // main -> audio triple buffer. the main thread fills snapshots[writeIndex]
+    // and swaps it into `latest`, the audio thread swaps `latest` with
+    // snapshots[readIndex] when it's fresh. nobody ever waits
+    Snapshot         snapshots[3];
+    std::atomic<int> latest{0};
+    int              writeIndex = 1;
+    int              readIndex  = 2;
+    static const int FRESH      = 4;         // flag bit in `latest`
+
+    // audio thread
     std::vector<std::unique_ptr<Oscillator>> oscillators;  // one per waveform type
-    mutable std::mutex mutex;
+    std::vector<VoiceState> voiceStates;
+    bool                    audioAggregate = false;
+    uint64_t                bufferCount    = 0;
+    std::atomic<int>        voiceCount{0};
+
+    // mono mixes at 1x/2x/4x the output rate, preallocated so the audio
+    // thread never allocates
+    std::vector<float> mixBuffer;
+    std::vector<float> mixBuffer2x;
+    std::vector<float> mixBuffer4x;
+
+    HalfbandDecimator decimate2x;   // 2x -> 1x
+    HalfbandDecimator decimate4x;   // 4x -> 2x
+    bool              decimating2x = false;
+    bool              decimating4x = false;
+
+    static const int MAX_PARTICLES            = 64;
+    static const int MAX_AGGREGATED_PARTICLES = 100000;
+    static const int MAX_BLOCK                = 4096;   // frames mixed per pass
+    static const size_t DETAILED_DRAW_LIMIT   = 2000;   // more particles than this draw coarse
 
-    static const int MAX_PARTICLES = 64;
+    // pitch bins for aggregation: AGGREGATE_CENTS wide, starting at LOWEST_FREQ
+    static constexpr float AGGREGATE_CENTS = 10.0f;
+    static constexpr float LOWEST_FREQ     = 20.0f;
+    static const int       BINS_PER_TYPE   = 1200;      // 10 octaves
+    static const int       MAX_VOICES      = NUM_TYPES * BINS_PER_TYPE;
 };
@@ -0,0 +1,406 @@
+// this file defines libc functions itself, so it needs their plain
+// declarations: no fortify wrappers and no 64-bit offset renames
+#undef _FORTIFY_SOURCE
+#undef _FILE_OFFSET_BITS
+
+#include "RealtimeChecker.h"
+#include <algorithm>
+#include <atomic>
+
+static std::atomic<int> violationCount{0};
+
+int RealtimeChecker::getViolationCount() {
+    return violationCount.load();
+}
+
+void RealtimeChecker::resetViolationCount() {
+    violationCount = 0;
+}
+
+#ifndef PARTICLESYNTH_RT_CHECK
+
+bool RealtimeChecker::isEnabled()          { return false; }
+bool RealtimeChecker::hasLibcHooks()       { return false; }
+bool RealtimeChecker::isInRealtimeScope()  { return false; }
+void RealtimeChecker::reportViolation(const char*) {}
+
+#else
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <unistd.h>
+#include <execinfo.h>
+
+// plain POD thread_locals so touching them never allocates
+static thread_local int  scopeDepth = 0;
+static thread_local bool reporting  = false;
+
+RealtimeScope::RealtimeScope()  { scopeDepth++; }
+RealtimeScope::~RealtimeScope() { scopeDepth--; }
+
+bool RealtimeChecker::isEnabled() { return true; }
+
+bool RealtimeChecker::isInRealtimeScope() {
+    return scopeDepth > 0 && !reporting;
+}
+
+void RealtimeChecker::reportViolation(const char* what) {
+    violationCount++;
+
+    // everything below allocates/writes, so switch the hooks off while reporting
+    reporting = true;
+    char msg[128];
+    int len = snprintf(msg, sizeof(msg),
+                       "[RealtimeChecker] %s on the audio thread\n", what);
+    // nothing useful to do if stderr is gone, the count still fails the run
+    ssize_t written = 0;
+    if (len > 0) written = ::write(STDERR_FILENO, msg, std::min(len, (int)sizeof(msg) - 1));
+
+    void* frames[32];
+    int depth = backtrace(frames, 32);
+    backtrace_symbols_fd(frames + 1, depth - 1, STDERR_FILENO);
+    written = ::write(STDERR_FILENO, "\n", 1);
+    (void)written;
+    reporting = false;
+}
+
+static inline void checkRealtime(const char* what) {
+    if (RealtimeChecker::isInRealtimeScope()) {
+        RealtimeChecker::reportViolation(what);
+    }
+}
+
+#if defined(__GLIBC__)
+
+// glibc: replace the libc entry points directly. the executable's symbols win
+// over libc's, so this also catches calls made from inside openFrameworks,
+// RtAudio and libstdc++ (std::mutex, operator new, ...)
+#include <dlfcn.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/select.h>
+#include <time.h>
+#include <cerrno>
+#include <cstdarg>
+
+bool RealtimeChecker::hasLibcHooks() { return true; }
+
+// the allocators call glibc's __libc_* versions, everything else forwards to
+// the real function looked up with dlsym.
+// stdio gets its own hooks: it goes through libc's internal __write/__open,
+// which the write/open hooks never see.
+// no function-local statics here - their init guard takes a lock
+using MutexLockFn     = int (*)(pthread_mutex_t*);
+using CondWaitFn      = int (*)(pthread_cond_t*, pthread_mutex_t*);
+using CondTimedWaitFn = int (*)(pthread_cond_t*, pthread_mutex_t*, const struct timespec*);
+using CondClockWaitFn = int (*)(pthread_cond_t*, pthread_mutex_t*, clockid_t, const struct timespec*);
+using SemWaitFn       = int (*)(sem_t*);
+using SemTimedWaitFn  = int (*)(sem_t*, const struct timespec*);
+using NanosleepFn     = int (*)(const struct timespec*, struct timespec*);
+using ClockSleepFn    = int (*)(clockid_t, int, const struct timespec*, struct timespec*);
+using UsleepFn        = int (*)(useconds_t);
+using ReadFn          = ssize_t (*)(int, void*, size_t);
+using WriteFn         = ssize_t (*)(int, const void*, size_t);
+using OpenFn          = int (*)(const char*, int, ...);
+using OpenatFn        = int (*)(int, const char*, int, ...);
+using FdFn            = int (*)(int);
+using PollFn          = int (*)(struct pollfd*, nfds_t, int);
+using SelectFn        = int (*)(int, fd_set*, fd_set*, fd_set*, struct timeval*);
+using FopenFn         = FILE* (*)(const char*, const char*);
+using FileFn          = int (*)(FILE*);
+using FreadFn         = size_t (*)(void*, size_t, size_t, FILE*);
+using FwriteFn        = size_t (*)(const void*, size_t, size_t, FILE*);
+using FputsFn         = int (*)(const char*, FILE*);
+using FputcFn         = int (*)(int, FILE*);
+
+static MutexLockFn     realMutexLock     = nullptr;
+static CondWaitFn      realCondWait      = nullptr;
+static CondTimedWaitFn realCondTimedWait = nullptr;
+static CondClockWaitFn realCondClockWait = nullptr;
+static SemWaitFn       realSemWait       = nullptr;
+static SemTimedWaitFn  realSemTimedWait  = nullptr;
+static NanosleepFn     realNanosleep     = nullptr;
+static ClockSleepFn    realClockSleep    = nullptr;
+static UsleepFn        realUsleep        = nullptr;
+static ReadFn          realRead          = nullptr;
+static WriteFn         realWrite         = nullptr;
+static OpenFn          realOpen          = nullptr;
+static OpenFn          realOpen64        = nullptr;
+static OpenatFn        realOpenat        = nullptr;
+static FdFn            realClose         = nullptr;
+static FdFn            realFsync         = nullptr;
+static FdFn            realFdatasync     = nullptr;
+static PollFn          realPoll          = nullptr;
+static SelectFn        realSelect        = nullptr;
+static FopenFn         realFopen         = nullptr;
+static FopenFn         realFopen64       = nullptr;
+static FileFn          realFclose        = nullptr;
+static FileFn          realFflush        = nullptr;
+static FreadFn         realFread         = nullptr;
+static FwriteFn        realFwrite        = nullptr;
+static FputsFn         realFputs         = nullptr;
+static FputcFn         realFputc         = nullptr;
+
+template <typename Fn>
+static Fn resolve(Fn& fn, const char* name) {
+    if (!fn) fn = reinterpret_cast<Fn>(dlsym(RTLD_NEXT, name));
+    return fn;
+}
+
+// the condition variable functions also exist in an old ABI version, and
+// plain dlsym can hand back that one. ask for the current one first
+template <typename Fn>
+static Fn resolveCond(Fn& fn, const char* name) {
+    if (!fn) fn = reinterpret_cast<Fn>(dlvsym(RTLD_NEXT, name, "GLIBC_2.3.2"));
+    return resolve(fn, name);
+}
+
+// mode is only passed (and only valid) when a file can be created
+static mode_t openMode(int flags, va_list args) {
+#ifdef O_TMPFILE
+    bool creates = (flags & O_CREAT) || (flags & O_TMPFILE) == O_TMPFILE;
+#else
+    bool creates = (flags & O_CREAT);
+#endif
+    return creates ? (mode_t)va_arg(args, int) : 0;
+}
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t align, size_t size);
+void  __libc_free(void* ptr);
+
+void* malloc(size_t size) __THROW {
+    checkRealtime("malloc");
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size) __THROW {
+    checkRealtime("calloc");
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, size_t size) __THROW {
+    checkRealtime("realloc");
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) __THROW {
+    if (ptr) checkRealtime("free");
+    __libc_free(ptr);
+}
+
+void* memalign(size_t align, size_t size) __THROW {
+    checkRealtime("memalign");
+    return __libc_memalign(align, size);
+}
+
+void* aligned_alloc(size_t align, size_t size) __THROW {
+    checkRealtime("aligned_alloc");
+    return __libc_memalign(align, size);
+}
+
+int posix_memalign(void** out, size_t align, size_t size) __THROW {
+    checkRealtime("posix_memalign");
+    void* p = __libc_memalign(align, size);
+    if (!p) return ENOMEM;
+    *out = p;
+    return 0;
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) __THROWNL {
+    checkRealtime("pthread_mutex_lock");
+    return resolve(realMutexLock, "pthread_mutex_lock")(mutex);
+}
+
+int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex) {
+    checkRealtime("pthread_cond_wait");
+    return resolveCond(realCondWait, "pthread_cond_wait")(cond, mutex);
+}
+
+int pthread_cond_timedwait(pthread_cond_t* cond, pthread_mutex_t* mutex,
+                           const struct timespec* abstime) {
+    checkRealtime("pthread_cond_timedwait");
+    return resolveCond(realCondTimedWait, "pthread_cond_timedwait")(cond, mutex, abstime);
+}
+
+#if __GLIBC_PREREQ(2, 30)
+// what std::condition_variable::wait_for/wait_until use on newer glibc
+int pthread_cond_clockwait(pthread_cond_t* cond, pthread_mutex_t* mutex,
+                           clockid_t clock, const struct timespec* abstime) {
+    checkRealtime("pthread_cond_clockwait");
+    return resolve(realCondClockWait, "pthread_cond_clockwait")(cond, mutex, clock, abstime);
+}
+#endif
+
+int sem_wait(sem_t* sem) {
+    checkRealtime("sem_wait");
+    return resolve(realSemWait, "sem_wait")(sem);
+}
+
+int sem_timedwait(sem_t* sem, const struct timespec* abstime) {
+    checkRealtime("sem_timedwait");
+    return resolve(realSemTimedWait, "sem_timedwait")(sem, abstime);
+}
+
+int nanosleep(const struct timespec* req, struct timespec* rem) {
+    checkRealtime("nanosleep");
+    return resolve(realNanosleep, "nanosleep")(req, rem);
+}
+
+int clock_nanosleep(clockid_t clock, int flags, const struct timespec* req,
+                    struct timespec* rem) {
+    checkRealtime("clock_nanosleep");
+    return resolve(realClockSleep, "clock_nanosleep")(clock, flags, req, rem);
+}
+
+int usleep(useconds_t usec) {
+    checkRealtime("usleep");
+    return resolve(realUsleep, "usleep")(usec);
+}
+
+ssize_t read(int fd, void* buf, size_t count) {
+    checkRealtime("read");
+    return resolve(realRead, "read")(fd, buf, count);
+}
+
+ssize_t write(int fd, const void* buf, size_t count) {
+    checkRealtime("write");
+    return resolve(realWrite, "write")(fd, buf, count);
+}
+
+int open(const char* path, int flags, ...) {
+    checkRealtime("open");
+    va_list args;
+    va_start(args, flags);
+    mode_t mode = openMode(flags, args);
+    va_end(args);
+    return resolve(realOpen, "open")(path, flags, mode);
+}
+
+int open64(const char* path, int flags, ...) {
+    checkRealtime("open64");
+    va_list args;
+    va_start(args, flags);
+    mode_t mode = openMode(flags, args);
+    va_end(args);
+    return resolve(realOpen64, "open64")(path, flags, mode);
+}
+
+int openat(int dirfd, const char* path, int flags, ...) {
+    checkRealtime("openat");
+    va_list args;
+    va_start(args, flags);
+    mode_t mode = openMode(flags, args);
+    va_end(args);
+    return resolve(realOpenat, "openat")(dirfd, path, flags, mode);
+}
+
+int close(int fd) {
+    checkRealtime("close");
+    return resolve(realClose, "close")(fd);
+}
+
+int fsync(int fd) {
+    checkRealtime("fsync");
+    return resolve(realFsync, "fsync")(fd);
+}
+
+int fdatasync(int fd) {
+    checkRealtime("fdatasync");
+    return resolve(realFdatasync, "fdatasync")(fd);
+}
+
+int poll(struct pollfd* fds, nfds_t nfds, int timeout) {
+    checkRealtime("poll");
+    return resolve(realPoll, "poll")(fds, nfds, timeout);
+}
+
+int select(int nfds, fd_set* readfds, fd_set* writefds, fd_set* exceptfds,
+           struct timeval* timeout) {
+    checkRealtime("select");
+    return resolve(realSelect, "select")(nfds, readfds, writefds, exceptfds, timeout);
+}
+
+FILE* fopen(const char* path, const char* mode) {
+    checkRealtime("fopen");
+    return resolve(realFopen, "fopen")(path, mode);
+}
+
+FILE* fopen64(const char* path, const char* mode) {
+    checkRealtime("fopen64");
+    return resolve(realFopen64, "fopen64")(path, mode);
+}
+
+int fclose(FILE* file) {
+    checkRealtime("fclose");
+    return resolve(realFclose, "fclose")(file);
+}
+
+int fflush(FILE* file) {
+    checkRealtime("fflush");
+    return resolve(realFflush, "fflush")(file);
+}
+
+size_t fread(void* ptr, size_t size, size_t n, FILE* file) {
+    checkRealtime("fread");
+    return resolve(realFread, "fread")(ptr, size, n, file);
+}
+
+size_t fwrite(const void* ptr, size_t size, size_t n, FILE* file) {
+    checkRealtime("fwrite");
+    return resolve(realFwrite, "fwrite")(ptr, size, n, file);
+}
+
+int fputs(const char* str, FILE* file) {
+    checkRealtime("fputs");
+    return resolve(realFputs, "fputs")(str, file);
+}
+
+// the compiler turns one-character fputs/fprintf into this
+int fputc(int c, FILE* file) {
+    checkRealtime("fputc");
+    return resolve(realFputc, "fputc")(c, file);
+}
+
+} // extern "C"
+
+#else
+
+bool RealtimeChecker::hasLibcHooks() { return false; }
+
+// everywhere else just catch C++ allocations
+void* operator new(std::size_t size) {
+    checkRealtime("operator new");
+    if (void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    checkRealtime("operator new[]");
+    if (void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr) checkRealtime("operator delete");
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    if (ptr) checkRealtime("operator delete[]");
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept   { operator delete(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { operator delete[](ptr); }
+
+#endif
+
+#endif // PARTICLESYNTH_RT_CHECK
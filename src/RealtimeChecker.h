@@ -0,0 +1,35 @@
+#pragma once
+
+// debug tool that catches non-realtime-safe calls on the audio thread.
+//
+// build with PARTICLESYNTH_RT_CHECK defined (see config.make) and every
+// malloc/free, lock or condition/semaphore wait, sleep, file or stdio call
+// made while a RealtimeScope is alive gets reported to stderr with a stack
+// trace. without the define RealtimeScope is empty and no hooks are compiled in.
+//
+// the libc hooks are Linux/glibc only - on other platforms only
+// operator new/delete are checked (hasLibcHooks() is false).
+class RealtimeChecker {
+public:
+    static bool isEnabled();            // true if compiled with the checker
+    static bool hasLibcHooks();         // locks, waits and I/O are checked too
+    static int  getViolationCount();
+    static void resetViolationCount();
+
+    // used by the hooks
+    static bool isInRealtimeScope();
+    static void reportViolation(const char* what);
+};
+
+// put one of these at the top of anything that runs on the audio thread
+class RealtimeScope {
+public:
+#ifdef PARTICLESYNTH_RT_CHECK
+    RealtimeScope();
+    ~RealtimeScope();
+#else
+    RealtimeScope() {}
+#endif
+    RealtimeScope(const RealtimeScope&) = delete;
+    RealtimeScope& operator=(const RealtimeScope&) = delete;
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+// tiny SIMD helpers for the DSP inner loops.
+// SSE on x86, NEON on ARM (Apple silicon), plain loops everywhere else.
+// loads are unaligned so any float buffer works, n must be a multiple of 4.
+
+#if defined(__SSE__) || defined(_M_X64)
+    #include <xmmintrin.h>
+    #define PARTICLESYNTH_SSE 1
+#elif defined(__ARM_NEON)
+    #include <arm_neon.h>
+    #define PARTICLESYNTH_NEON 1
+#endif
+
+namespace Simd {
+
+// acc += a * b on split complex arrays
+inline void complexMultiplyAccumulate(float* accRe, float* accIm,
+                                      const float* aRe, const float* aIm,
+                                      const float* bRe, const float* bIm,
+                                      int n) {
+#if defined(PARTICLESYNTH_SSE)
+    for (int i = 0; i < n; i += 4) {
+        __m128 ar = _mm_loadu_ps(aRe + i), ai = _mm_loadu_ps(aIm + i);
+        __m128 br = _mm_loadu_ps(bRe + i), bi = _mm_loadu_ps(bIm + i);
+        __m128 re = _mm_sub_ps(_mm_mul_ps(ar, br), _mm_mul_ps(ai, bi));
+        __m128 im = _mm_add_ps(_mm_mul_ps(ar, bi), _mm_mul_ps(ai, br));
+        _mm_storeu_ps(accRe + i, _mm_add_ps(_mm_loadu_ps(accRe + i), re));
+        _mm_storeu_ps(accIm + i, _mm_add_ps(_mm_loadu_ps(accIm + i), im));
+    }
+#elif defined(PARTICLESYNTH_NEON)
+    for (int i = 0; i < n; i += 4) {
+        float32x4_t ar = vld1q_f32(aRe + i), ai = vld1q_f32(aIm + i);
+        float32x4_t br = vld1q_f32(bRe + i), bi = vld1q_f32(bIm + i);
+        float32x4_t re = vld1q_f32(accRe + i);
+        float32x4_t im = vld1q_f32(accIm + i);
+        re = vmlaq_f32(re, ar, br);
+        re = vmlsq_f32(re, ai, bi);
+        im = vmlaq_f32(im, ar, bi);
+        im = vmlaq_f32(im, ai, br);
+        vst1q_f32(accRe + i, re);
+        vst1q_f32(accIm + i, im);
+    }
+#else
+    for (int i = 0; i < n; i++) {
+        accRe[i] += aRe[i] * bRe[i] - aIm[i] * bIm[i];
+        accIm[i] += aRe[i] * bIm[i] + aIm[i] * bRe[i];
+    }
+#endif
+}
+
+// returns sum of a[i] * b[i]
+inline float dotProduct(const float* a, const float* b, int n) {
+#if defined(PARTICLESYNTH_SSE)
+    __m128 sum = _mm_setzero_ps();
+    for (int i = 0; i < n; i += 4) {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, sum);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(PARTICLESYNTH_NEON)
+    float32x4_t sum = vdupq_n_f32(0.0f);
+    for (int i = 0; i < n; i += 4) {
+        sum = vmlaq_f32(sum, vld1q_f32(a + i), vld1q_f32(b + i));
+    }
+    float32x2_t half = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+    return vget_lane_f32(vpadd_f32(half, half), 0);
+#else
+    float sum = 0.0f;
+    for (int i = 0; i < n; i++) sum += a[i] * b[i];
+    return sum;
+#endif
+}
+
+} // namespace Simd
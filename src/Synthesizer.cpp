@@ -1,17 +1,26 @@
 #include "Synthesizer.h"
+#include "RealtimeChecker.h"
+#include "Trace.h"
 
-void Synthesizer::setup(ParticleSystem* ps, int sr, int bs) {
+void Synthesizer::setup(ParticleSystem* ps, int sr, int bs, int numChannels) {
     particleSystem = ps;
     sampleRate     = sr;
     bufferSize     = bs;
     waveformDisplay.resize(bufferSize, 0.0f);
+    recorder.setup(sampleRate, numChannels);
 }
 
 void Synthesizer::close() {
-    // ofApp owns the sound stream so nothing to clean up here
+    // ofApp owns the sound stream, just finish any recording
+    // and stop the reverb's worker thread
+    recorder.stop();
+    reverb.close();
 }
 
 void Synthesizer::audioOut(ofSoundBuffer& buffer) {
+    RealtimeScope realtime;  // only does something in PARTICLESYNTH_RT_CHECK builds
+    Trace::setThreadName("audio");
+    TRACE_SCOPE("Synthesizer::audioOut");
     if (!particleSystem) return;
 
     particleSystem->fillBuffer(buffer.getBuffer().data(),
@@ -19,12 +28,20 @@ void Synthesizer::audioOut(ofSoundBuffer& buffer) {
                                buffer.getNumChannels(),
                                sampleRate);
 
-    // grab left channel for the scope
-    {
-        std::lock_guard<std::mutex> lock(waveformMutex);
-        int frames = buffer.getNumFrames();
+    reverb.process(buffer.getBuffer().data(),
+                   buffer.getNumFrames(),
+                   buffer.getNumChannels());
+
+    recorder.push(buffer.getBuffer().data(),
+                  buffer.getNumFrames(),
+                  buffer.getNumChannels());
+
+    // grab left channel for the scope. never wait on the draw thread here,
+    // if it's holding the lock we just skip this buffer
+    std::unique_lock<std::mutex> lock(waveformMutex, std::try_to_lock);
+    if (lock.owns_lock()) {
+        int frames = ofMin((int)buffer.getNumFrames(), (int)waveformDisplay.size());
         int chans  = buffer.getNumChannels();
-        waveformDisplay.resize(frames);
         for (int i = 0; i < frames; i++) {
             waveformDisplay[i] = buffer.getBuffer()[i * chans];
         }
@@ -1,6 +1,8 @@
 #pragma once
 #include "ofMain.h"
 #include "ParticleSystem.h"
+#include "AudioRecorder.h"
+#include "ConvolutionReverb.h"
 #include <mutex>
 #include <vector>
 
@@ -9,7 +11,7 @@
 class Synthesizer {
 public:
     void setup(ParticleSystem* particleSystem,
-               int sampleRate = 44100, int bufferSize = 512);
+               int sampleRate = 44100, int bufferSize = 512, int numChannels = 2);
     void close();
 
     void audioOut(ofSoundBuffer& buffer);  // called from audio thread
@@ -17,11 +19,18 @@ public:
 
     int getSampleRate() const { return sampleRate; }
 
+    // master bus effects + recording, controlled from the main thread
+    ConvolutionReverb& getReverb()   { return reverb; }
+    AudioRecorder&     getRecorder() { return recorder; }
+
 private:
     ParticleSystem* particleSystem = nullptr;
     int sampleRate  = 44100;
     int bufferSize  = 512;
 
+    ConvolutionReverb reverb;
+    AudioRecorder     recorder;
+
     // copy of last audio buffer for visualization
     std::vector<float> waveformDisplay;
     std::mutex         waveformMutex;
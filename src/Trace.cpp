@@ -0,0 +1,150 @@
+#include "Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+std::atomic<bool> Trace::enabled{false};
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    uint64_t    start;
+    uint64_t    end;
+};
+
+// one per thread. only the owning thread writes events/head,
+// exportJson() reads them from the main thread
+struct ThreadBuffer {
+    static const int CAPACITY = 16384;     // power of two
+
+    std::atomic<bool>        inUse{false};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint64_t>    head{0};      // total events ever written
+    TraceEvent               events[CAPACITY];
+};
+
+const int MAX_THREADS = 16;
+ThreadBuffer buffers[MAX_THREADS];
+
+// set at static init so now() never hits a function-local static guard
+const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+
+thread_local ThreadBuffer* threadBuffer = nullptr;
+thread_local bool          outOfBuffers = false;
+
+bool tryClaim(ThreadBuffer& buf) {
+    bool expected = false;
+    return buf.inUse.compare_exchange_strong(expected, true);
+}
+
+// threads that come and go (recorder, reverb worker) pick up the buffer a
+// previous thread with the same name released, so they stay on one track
+ThreadBuffer* getThreadBuffer(const char* name = nullptr) {
+    if (threadBuffer || outOfBuffers) return threadBuffer;
+
+    if (name) {
+        for (auto& buf : buffers) {
+            const char* old = buf.name.load(std::memory_order_acquire);
+            if (old && std::strcmp(old, name) == 0 && tryClaim(buf)) {
+                return threadBuffer = &buf;
+            }
+        }
+    }
+    for (auto& buf : buffers) {
+        if (buf.head.load() == 0 && !buf.name.load() && tryClaim(buf)) {
+            return threadBuffer = &buf;
+        }
+    }
+    outOfBuffers = true;                   // too many threads, this one goes untraced
+    return nullptr;
+}
+
+// JSON strings - zone names are our own literals but escape anyway
+std::string escape(const char* s) {
+    std::string out;
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') out += '\\';
+        out += *s;
+    }
+    return out;
+}
+
+} // namespace
+
+uint64_t Trace::now() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now() - origin).count();
+}
+
+void Trace::setThreadName(const char* name) {
+    ThreadBuffer* buf = getThreadBuffer(name);
+    if (buf) buf->name.store(name, std::memory_order_release);
+}
+
+void Trace::releaseThread() {
+    if (threadBuffer) threadBuffer->inUse = false;
+    threadBuffer = nullptr;
+}
+
+void Trace::record(const char* name, uint64_t startNs, uint64_t endNs) {
+    ThreadBuffer* buf = getThreadBuffer();
+    if (!buf) return;
+
+    uint64_t h = buf->head.load(std::memory_order_relaxed);
+    buf->events[h & (ThreadBuffer::CAPACITY - 1)] = { name, startNs, endNs };
+    buf->head.store(h + 1, std::memory_order_release);
+}
+
+bool Trace::exportJson(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) return false;
+
+    out << std::fixed << std::setprecision(3);   // timestamps in us
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    auto separator = [&]() {
+        if (!first) out << ",\n";
+        first = false;
+    };
+
+    std::vector<TraceEvent> events;
+    events.reserve(ThreadBuffer::CAPACITY);
+    for (int tid = 0; tid < MAX_THREADS; tid++) {
+        ThreadBuffer& buf = buffers[tid];
+
+        const char* name = buf.name.load(std::memory_order_acquire);
+        if (!name && buf.head.load() == 0) continue;   // never used
+        separator();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+            << ",\"args\":{\"name\":\"" << escape(name ? name : "thread") << "\"}}";
+
+        // copy out the newest events, then throw away any the owning thread
+        // overwrote (or is overwriting right now) while we were copying
+        const uint64_t capacity = ThreadBuffer::CAPACITY;
+        uint64_t head  = buf.head.load(std::memory_order_acquire);
+        uint64_t begin = head > capacity ? head - capacity : 0;
+        events.clear();
+        for (uint64_t i = begin; i < head; i++) {
+            events.push_back(buf.events[i & (capacity - 1)]);
+        }
+        uint64_t headAfter = buf.head.load(std::memory_order_acquire);
+        uint64_t validFrom = headAfter + 1 > capacity ? headAfter + 1 - capacity : 0;
+        size_t   torn      = validFrom > begin
+                           ? std::min<size_t>(events.size(), validFrom - begin) : 0;
+
+        for (size_t i = torn; i < events.size(); i++) {
+            const TraceEvent& e = events[i];
+            separator();
+            out << "{\"name\":\"" << escape(e.name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                << ",\"ts\":" << e.start / 1000.0
+                << ",\"dur\":" << (e.end - e.start) / 1000.0 << "}";
+        }
+    }
+
+    out << "\n]}\n";
+    return (bool)out;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// lightweight cross-thread profiler.
+//
+//   void ParticleSystem::update() {
+//       TRACE_SCOPE("ParticleSystem::update");
+//       ...
+//
+// each thread writes finished zones into its own fixed-size ring (claimed
+// from a static pool the first time it records, so no allocation or locking
+// ever happens on the audio thread). the rings keep the most recent events
+// and can be dumped as Chrome/Perfetto JSON (open in ui.perfetto.dev or
+// chrome://tracing).
+//
+// when tracing is off a zone costs one relaxed atomic load. define
+// PARTICLESYNTH_NO_TRACE to compile the zones out completely.
+class Trace {
+public:
+    static void setEnabled(bool val) { enabled.store(val, std::memory_order_relaxed); }
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // shows up as the track name in the trace viewer. name must be a literal
+    static void setThreadName(const char* name);
+    // short-lived threads call this before exiting so their ring can be reused
+    static void releaseThread();
+
+    // writes everything currently in the rings, safe to call while tracing
+    static bool exportJson(const std::string& path);
+
+    static uint64_t now();   // ns since startup
+    static void record(const char* name, uint64_t startNs, uint64_t endNs);
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+class TraceScope {
+public:
+    explicit TraceScope(const char* zoneName)
+        : name(Trace::isEnabled() ? zoneName : nullptr) {
+        if (name) start = Trace::now();
+    }
+    ~TraceScope() {
+        if (name) Trace::record(name, start, Trace::now());
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    uint64_t    start = 0;
+};
+
+#ifdef PARTICLESYNTH_NO_TRACE
+    #define TRACE_SCOPE(name)
+#else
+    #define TRACE_CONCAT_(a, b) a##b
+    #define TRACE_CONCAT(a, b)  TRACE_CONCAT_(a, b)
+    #define TRACE_SCOPE(name)   TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#endif
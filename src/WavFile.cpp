@@ -0,0 +1,186 @@
+#include "WavFile.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// RIFF is little endian, write byte by byte so host order doesn't matter
+static void put16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = (v >> 24) & 0xff;
+}
+
+static uint16_t get16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static const int WAV_HEADER_SIZE = 44;
+
+bool loadWav(const std::string& path, std::vector<float>& samples,
+             int& sampleRate, int& numChannels) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+
+    std::vector<uint8_t> bytes;
+    uint8_t buf[1 << 16];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        bytes.insert(bytes.end(), buf, buf + n);
+    }
+    fclose(f);
+
+    if (bytes.size() < 12 || !std::equal(bytes.begin(), bytes.begin() + 4, "RIFF")
+        || !std::equal(bytes.begin() + 8, bytes.begin() + 12, "WAVE")) {
+        return false;
+    }
+
+    // walk the chunks, we only care about fmt and data
+    int format = 0, bits = 0;
+    const uint8_t* data = nullptr;
+    size_t dataSize = 0;
+    size_t pos = 12;
+    while (pos + 8 <= bytes.size()) {
+        const uint8_t* chunk = &bytes[pos];
+        size_t chunkSize = get32(chunk + 4);
+        size_t body      = pos + 8;
+        chunkSize = std::min(chunkSize, bytes.size() - body);
+
+        if (std::equal(chunk, chunk + 4, "fmt ") && chunkSize >= 16) {
+            format      = get16(chunk + 8);
+            numChannels = get16(chunk + 10);
+            sampleRate  = get32(chunk + 12);
+            bits        = get16(chunk + 22);
+            // WAVE_FORMAT_EXTENSIBLE keeps the real format in the sub format GUID
+            if (format == 0xfffe && chunkSize >= 26) format = get16(chunk + 32);
+        } else if (std::equal(chunk, chunk + 4, "data")) {
+            data     = chunk + 8;
+            dataSize = chunkSize;
+        }
+        pos = body + chunkSize + (chunkSize & 1);   // chunks are word aligned
+    }
+
+    bool pcm   = format == 1 && (bits == 16 || bits == 24 || bits == 32);
+    bool ieee  = format == 3 && bits == 32;
+    if (!data || numChannels <= 0 || (!pcm && !ieee)) return false;
+
+    int    bytesPerSample = bits / 8;
+    size_t count = dataSize / bytesPerSample;
+    count -= count % numChannels;
+    samples.resize(count);
+
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* p = data + i * bytesPerSample;
+        if (ieee) {
+            uint32_t v = get32(p);
+            float s;
+            std::memcpy(&s, &v, sizeof(s));
+            samples[i] = s;
+        } else if (bits == 16) {
+            samples[i] = (int16_t)get16(p) / 32768.0f;
+        } else if (bits == 24) {
+            int32_t v = (int32_t)((p[0] << 8) | (p[1] << 16) | ((uint32_t)p[2] << 24)) >> 8;
+            samples[i] = v / 8388608.0f;
+        } else {
+            samples[i] = (int32_t)get32(p) / 2147483648.0f;
+        }
+    }
+    return true;
+}
+
+static void writeHeader(FILE* f, int sampleRate, int numChannels, uint32_t dataBytes) {
+    uint8_t h[WAV_HEADER_SIZE];
+    std::copy_n("RIFF", 4, h);
+    put32(h + 4, 36 + dataBytes);
+    std::copy_n("WAVE", 4, h + 8);
+
+    std::copy_n("fmt ", 4, h + 12);
+    put32(h + 16, 16);                              // fmt chunk size
+    put16(h + 20, 1);                               // PCM
+    put16(h + 22, numChannels);
+    put32(h + 24, sampleRate);
+    put32(h + 28, sampleRate * numChannels * 2);    // byte rate
+    put16(h + 32, numChannels * 2);                 // block align
+    put16(h + 34, 16);                              // bits per sample
+
+    std::copy_n("data", 4, h + 36);
+    put32(h + 40, dataBytes);
+
+    fwrite(h, 1, WAV_HEADER_SIZE, f);
+}
+
+WavWriter::~WavWriter() {
+    close();
+}
+
+bool WavWriter::open(const std::string& path, int rate, int channels) {
+    close();
+
+    file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+
+    // big stdio buffer so each write() goes to disk in one piece
+    setvbuf(file, nullptr, _IOFBF, 1 << 20);
+
+    sampleRate  = rate;
+    numChannels = channels;
+    dataBytes   = 0;
+    full        = false;
+    failed      = false;
+
+    // placeholder sizes, fixed up in close()
+    writeHeader(file, sampleRate, numChannels, 0);
+    return true;
+}
+
+bool WavWriter::write(const float* samples, size_t numSamples) {
+    if (failed) return false;
+    if (!file || full) return true;
+
+    // stop cleanly at the 4GB limit instead of wrapping the size fields
+    // (that's about 6.7 hours of 44.1k stereo)
+    uint64_t maxBytes = 0xffffffffull - WAV_HEADER_SIZE;
+    if (dataBytes + numSamples * 2 > maxBytes) {
+        numSamples = (size_t)((maxBytes - dataBytes) / 2);
+        numSamples -= numSamples % numChannels;
+        full = true;
+    }
+
+    pcm.resize(numSamples);
+    for (size_t i = 0; i < numSamples; i++) {
+        float s = std::min(1.0f, std::max(-1.0f, samples[i]));
+        pcm[i] = (int16_t)std::lrintf(s * 32767.0f);
+    }
+    // samples are written in host order - fine on x86/ARM which are both little endian.
+    // flushed right away so a failure shows up here, not in close(). only
+    // fully written calls are counted, the header never claims a partial one
+    size_t done = fwrite(pcm.data(), sizeof(int16_t), numSamples, file);
+    if (done < numSamples || fflush(file) != 0) {
+        failed = true;
+        return false;
+    }
+    dataBytes += (uint32_t)(numSamples * 2);
+    return true;
+}
+
+void WavWriter::close() {
+    if (!file) return;
+
+    fseek(file, 0, SEEK_SET);
+    writeHeader(file, sampleRate, numChannels, dataBytes);
+    fclose(file);
+    file = nullptr;
+}
+
+uint64_t WavWriter::getFramesWritten() const {
+    return dataBytes / (2 * numChannels);
+}
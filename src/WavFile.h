@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// reads a whole WAV file into interleaved floats in [-1, 1].
+// handles 16/24/32-bit PCM and 32-bit float. returns false on anything else.
+bool loadWav(const std::string& path, std::vector<float>& samples,
+             int& sampleRate, int& numChannels);
+
+// streams 16-bit PCM WAV to disk. sizes in the header are patched on close(),
+// so a file is only valid once it's been closed. the header only ever counts
+// samples that made it to disk, so a file that hit a write error (disk full)
+// still closes into a valid, shorter recording.
+// not thread safe - meant to be owned by a single writer thread.
+class WavWriter {
+public:
+    ~WavWriter();
+
+    bool open(const std::string& path, int sampleRate, int numChannels);
+    bool write(const float* samples, size_t numSamples);   // interleaved, false once a write failed
+    void close();
+
+    bool     isOpen() const { return file != nullptr; }
+    bool     hasError() const { return failed; }
+    uint64_t getFramesWritten() const;
+
+private:
+    FILE*    file        = nullptr;
+    int      sampleRate  = 44100;
+    int      numChannels = 2;
+    uint32_t dataBytes   = 0;
+    bool     full        = false;   // hit the 4GB RIFF limit
+    bool     failed      = false;   // a write came up short, nothing more is written
+
+    std::vector<int16_t> pcm;       // conversion scratch
+};
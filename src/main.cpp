@@ -1,8 +1,147 @@
 #include "ofMain.h"
 #include "ofApp.h"
+#include "RealtimeChecker.h"
+#include "Trace.h"
+#include "InputAnalyzer.h"
+#include "WavFile.h"
+#include <cstdio>
+
+// headless render test for the realtime checker:
+//   ./ParticleSynth --rt-check
+// pushes a few seconds of buffers through Synthesizer::audioOut while the
+// main thread spawns and updates like it would while playing. every second
+// another part of the audio path gets switched on: merged voices, 4x
+// oversampling, the reverb (with a generated IR), recording. the output is
+// looped back into the input analysis the whole time. while voices aren't
+// merged yet, short lived particles come and go so their voice slots get
+// reused, and no two live particles may ever share one.
+// exits with 1 if anything unsafe happened on the audio path, if particles
+// shared a voice, or if it only rendered silence (nothing would have been
+// checked). needs a
+// PARTICLESYNTH_RT_CHECK build to actually check anything.
+static int runRealtimeCheck() {
+    if (!RealtimeChecker::isEnabled()) {
+        ofLogError("main") << "--rt-check needs a build with PARTICLESYNTH_RT_CHECK defined";
+        return 1;
+    }
+    // new/delete alone would pass with a mutex or file I/O in the callback
+    if (!RealtimeChecker::hasLibcHooks()) {
+        ofLogError("main") << "--rt-check only checks new/delete on this platform, "
+                           << "run it on Linux (glibc) for a real result";
+        return 1;
+    }
+
+    int sampleRate = 44100;
+    int bufSize    = 512;
+
+    ParticleSystem particleSystem;
+    Synthesizer    synth;
+    synth.setup(&particleSystem, sampleRate, bufSize);
+
+    // short decaying noise burst as the impulse response
+    std::string irPath  = ofToDataPath("rt-check-ir.wav");
+    std::string recPath = ofToDataPath("rt-check-recording.wav");
+    {
+        std::vector<float> ir(sampleRate / 2);
+        uint32_t seed = 1;
+        for (size_t i = 0; i < ir.size(); i++) {
+            seed = seed * 1664525u + 1013904223u;
+            ir[i] = (seed * (2.0f / 4294967295.0f) - 1.0f) * expf(-8.0f * i / sampleRate);
+        }
+        WavWriter wav;
+        wav.open(irPath, sampleRate, 1);
+        wav.write(ir.data(), ir.size());
+    }
+    synth.getReverb().load(irPath, sampleRate);
+
+    InputAnalyzer inputAnalyzer;
+    inputAnalyzer.setup(sampleRate);
+    inputAnalyzer.setEnabled(true);
+
+    ofSoundBuffer buffer;
+    buffer.setSampleRate(sampleRate);
+    buffer.allocate(bufSize, 2);
+
+    int numTypes = static_cast<int>(OscType::COUNT);
+    for (int i = 0; i < 16; i++) {
+        particleSystem.spawn(glm::vec2(100 + i * 10, 100),
+                             static_cast<OscType>(i % numTypes),
+                             110.0f + i * 40.0f);
+    }
+
+    RealtimeChecker::resetViolationCount();
+    int   buffersPerSecond = sampleRate / bufSize;
+    int   numBuffers       = 5 * buffersPerSecond;
+    float dt               = (float)bufSize / sampleRate;   // no window, so no frame time
+    float peak             = 0.0f;
+    int   sharedSlots      = 0;
+    for (int i = 0; i < numBuffers; i++) {
+        // next stage, switched on from the main thread like a key press
+        if (i == 1 * buffersPerSecond) particleSystem.setVoiceAggregation(true);
+        if (i == 2 * buffersPerSecond) {
+            particleSystem.setOversampling(OscType::SQUARE, 4);
+            particleSystem.setOversampling(OscType::SAW, 4);
+        }
+        if (i == 3 * buffersPerSecond) synth.getReverb().setEnabled(true);
+        if (i == 4 * buffersPerSecond) synth.getRecorder().start(recPath);
+
+        if (particleSystem.isVoiceAggregationEnabled()) {
+            if (i % 8 == 0) {
+                for (int n = 0; n < 200; n++) {
+                    particleSystem.spawn(glm::vec2(200, 200),
+                                         static_cast<OscType>((i + n) % numTypes),
+                                         220.0f + n * 3.0f);
+                }
+            }
+        } else if (i % 2 == 0) {
+            // mixed lifetimes, so they die out of order
+            particleSystem.spawn(glm::vec2(200, 200),
+                                 static_cast<OscType>(i % numTypes),
+                                 220.0f + i * 3.0f, 0.5f, 0.05f + (i / 2 % 5) * 0.1f);
+        }
+        particleSystem.update(dt);   // publishes to the audio thread, like the main loop
+        if (!particleSystem.voiceSlotsAreUnique()) sharedSlots++;
+        synth.audioOut(buffer);
+        inputAnalyzer.audioIn(buffer.getBuffer().data(), bufSize, 2);
+
+        for (float s : buffer.getBuffer()) peak = ofMax(peak, fabsf(s));
+    }
+    int violations = RealtimeChecker::getViolationCount();
+
+    synth.close();
+    inputAnalyzer.close();
+    std::remove(irPath.c_str());
+    std::remove(recPath.c_str());
+
+    if (violations > 0) {
+        ofLogError("main") << "realtime check FAILED: " << violations
+                           << " violations in " << numBuffers << " buffers";
+        return 1;
+    }
+    if (sharedSlots > 0) {
+        ofLogError("main") << "realtime check FAILED: live particles shared a voice slot in "
+                           << sharedSlots << " buffers";
+        return 1;
+    }
+    if (peak <= 0.0f) {
+        ofLogError("main") << "realtime check FAILED: rendered only silence";
+        return 1;
+    }
+    ofLogNotice("main") << "realtime check passed (" << numBuffers << " buffers)";
+    return 0;
+}
 
 //========================================================================
-int main( ){
+int main(int argc, char* argv[]){
+
+	std::string inputWav;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--rt-check") return runRealtimeCheck();
+		if (arg == "--trace") Trace::setEnabled(true);   // profile from the first frame
+		// test the input analysis without a mic: --input-wav path/to/file.wav
+		if (arg == "--input-wav" && i + 1 < argc) inputWav = argv[++i];
+	}
 
 	//Use ofGLFWWindowSettings for more options like multi-monitor fullscreen
 	ofGLWindowSettings settings;
@@ -11,7 +150,9 @@ int main( ){
 
 	auto window = ofCreateWindow(settings);
 
-	ofRunApp(window, std::make_shared<ofApp>());
+	auto app = std::make_shared<ofApp>();
+	app->setInputFile(inputWav);
+	ofRunApp(window, app);
 	ofRunMainLoop();
 
 }
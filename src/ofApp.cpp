@@ -1,4 +1,6 @@
 #include "ofApp.h"
+#include "RealtimeChecker.h"
+#include "Trace.h"
 
 // keyboard -> note frequency mapping (piano layout on QWERTY)
 //
@@ -29,6 +31,7 @@ static const std::map<int, float> noteMap = {
 
 //--------------------------------------------------------------
 void ofApp::setup() {
+    Trace::setThreadName("main");
     ofSetFrameRate(60);
     ofBackground(10, 10, 20);
     ofSetCircleResolution(32);
@@ -37,16 +40,44 @@ void ofApp::setup() {
     // audio setup
     int sampleRate = 44100;
     int bufSize    = 512;
-    synth.setup(&particleSystem, sampleRate, bufSize);
+    int numChannels = 2;
+    synth.setup(&particleSystem, sampleRate, bufSize, numChannels);
+
+    // optional master reverb, drop any WAV impulse response in bin/data
+    std::string irPath = ofToDataPath("impulse.wav");
+    if (ofFile::doesFileExist(irPath)) {
+        synth.getReverb().load(irPath, sampleRate);
+    }
+
+    // input analysis (mic, or a WAV standing in for it), off until I is pressed
+    inputAnalyzer.setup(sampleRate);
+    if (!inputFilePath.empty() && inputAnalyzer.setFileSource(inputFilePath)) {
+        inputAnalyzer.setEnabled(true);
+    }
 
     ofSoundStreamSettings ss;
     ss.setOutListener(this);
     ss.sampleRate        = sampleRate;
-    ss.numOutputChannels = 2;
+    ss.numOutputChannels = numChannels;
     ss.numInputChannels  = 0;
     ss.bufferSize        = bufSize;
     ss.numBuffers        = 4;
-    soundStream.setup(ss);
+
+    // open the mic too if there is one (not needed when a file stands in).
+    // a duplex stream fails without an input device, so fall back to output only
+    if (!inputAnalyzer.hasFileSource()) {
+        ofSoundStreamSettings duplex = ss;
+        duplex.setInListener(this);
+        duplex.numInputChannels = 1;
+        hasAudioInput = soundStream.setup(duplex);
+        if (!hasAudioInput) {
+            ofLogWarning("ofApp") << "no audio input, opening output only";
+            soundStream.close();
+        }
+    }
+    if (!hasAudioInput && !soundStream.setup(ss)) {
+        ofLogError("ofApp") << "couldn't open the audio output";
+    }
 
     // webcam off by default, use keyboard/mouse first
     gestureTracker.setup(640, 480);
@@ -55,9 +86,15 @@ void ofApp::setup() {
 
 //--------------------------------------------------------------
 void ofApp::update() {
-    particleSystem.update();
+    TRACE_SCOPE("ofApp::update");
     gestureTracker.update();
 
+    // notes heard on the input
+    InputAnalyzer::Onset onset;
+    while (inputAnalyzer.popOnset(onset)) {
+        spawnFromInput(onset);
+    }
+
     // if webcam is on, spawn particles where blobs are detected
     if (gestureTracker.isEnabled() && gestureTracker.hasBlob()) {
         for (int i = 0; i < gestureTracker.getNumBlobs(); i++) {
@@ -70,10 +107,14 @@ void ofApp::update() {
             }
         }
     }
+
+    // last, so this frame's spawns go out to the audio thread right away
+    particleSystem.update();
 }
 
 //--------------------------------------------------------------
 void ofApp::draw() {
+    TRACE_SCOPE("ofApp::draw");
     drawZoneGuides();
 
     particleSystem.draw();
@@ -94,6 +135,7 @@ void ofApp::draw() {
 //--------------------------------------------------------------
 void ofApp::exit() {
     soundStream.close();
+    inputAnalyzer.close();
     synth.close();
 }
 
@@ -102,6 +144,11 @@ void ofApp::audioOut(ofSoundBuffer& buffer) {
     synth.audioOut(buffer);
 }
 
+void ofApp::audioIn(ofSoundBuffer& buffer) {
+    inputAnalyzer.audioIn(buffer.getBuffer().data(),
+                          (int)buffer.getNumFrames(), (int)buffer.getNumChannels());
+}
+
 //--------------------------------------------------------------
 void ofApp::keyPressed(int key) {
     // switch waveform
@@ -112,6 +159,56 @@ void ofApp::keyPressed(int key) {
 
     if (key == ' ') { particleSystem.clear(); return; }
 
+    // oversample the waveforms that alias (square + saw): off -> 2x -> 4x
+    if (key == 'z') {
+        int factor = particleSystem.getOversampling(OscType::SAW);
+        factor = (factor >= 4) ? 1 : factor * 2;
+        particleSystem.setOversampling(OscType::SQUARE, factor);
+        particleSystem.setOversampling(OscType::SAW, factor);
+        return;
+    }
+
+    // spawn particles from notes played into the mic
+    if (key == 'i') {
+        inputAnalyzer.setEnabled(!inputAnalyzer.isEnabled());
+        return;
+    }
+
+    if (key == 'v') {
+        ConvolutionReverb& reverb = synth.getReverb();
+        if (reverb.isLoaded()) reverb.setEnabled(!reverb.isEnabled());
+        return;
+    }
+
+    // merge same-pitch particles into shared voices (allows huge particle counts)
+    if (key == 'm') {
+        particleSystem.setVoiceAggregation(!particleSystem.isVoiceAggregationEnabled());
+        return;
+    }
+
+    // record the master output to bin/data
+    if (key == 'r') {
+        AudioRecorder& rec = synth.getRecorder();
+        if (rec.isRecording()) {
+            rec.stop();
+        } else {
+            rec.start(ofToDataPath("recording-" + ofGetTimestampString() + ".wav"));
+        }
+        return;
+    }
+
+    // profiling: X = tracing on/off, x = dump the trace rings to bin/data
+    if (key == 'X') { Trace::setEnabled(!Trace::isEnabled()); return; }
+    if (key == 'x') {
+        std::string path = ofToDataPath("trace-" + ofGetTimestampString() + ".json");
+        if (Trace::exportJson(path)) {
+            ofLogNotice("ofApp") << "trace written to " << path;
+        } else {
+            ofLogError("ofApp") << "couldn't write trace to " << path;
+        }
+        return;
+    }
+
     // webcam controls
     if (key == 'c') {
         gestureTracker.setEnabled(!gestureTracker.isEnabled());
@@ -165,6 +262,28 @@ void ofApp::spawnAtPosition(float x, float y, OscType type) {
     particleSystem.spawn(glm::vec2(x, y), type, freq);
 }
 
+void ofApp::spawnFromInput(const InputAnalyzer::Onset& onset) {
+    // unpitched hits (drums, claps) become noise
+    if (onset.frequency <= 0) {
+        float x = ofGetWidth() * 0.875f + ofRandom(-60, 60);
+        float y = ofGetHeight() * 0.5f  + ofRandom(-80, 80);
+        particleSystem.spawn(glm::vec2(x, y), OscType::NOISE, frequencyFromY(y),
+                             onset.strength * 0.6f);
+        return;
+    }
+
+    // keep the heard pitch but fold it into the screen's 110-880 range by octaves
+    float freq = onset.frequency;
+    while (freq > 880.0f) freq *= 0.5f;
+    while (freq < 110.0f) freq *= 2.0f;
+
+    // same place a mouse click for this note would go, in the current waveform's zone
+    float zone = static_cast<int>(currentOscType) + 0.5f;
+    float x = ofGetWidth() * zone * 0.25f + ofRandom(-60, 60);
+    float y = ofMap(freq, 880.0f, 110.0f, 0, ofGetHeight(), true);
+    particleSystem.spawn(glm::vec2(x, y), currentOscType, freq, onset.strength * 0.6f);
+}
+
 float ofApp::frequencyFromY(float y) {
     // top = high pitch, bottom = low (3 octave range)
     return ofMap(y, 0, ofGetHeight(), 880.0f, 110.0f, true);
@@ -213,7 +332,14 @@ void ofApp::drawUI() {
     y += 18;
 
     ofDrawBitmapString("Particles: "
-        + ofToString(particleSystem.getParticleCount()) + " / 64", 10, y);
+        + ofToString(particleSystem.getParticleCount()) + " / "
+        + ofToString(particleSystem.getMaxParticles()), 10, y);
+    y += 18;
+
+    ofDrawBitmapString("Voices: "
+        + ofToString(particleSystem.getVoiceCount())
+        + (particleSystem.isVoiceAggregationEnabled() ? "  (merged)" : "")
+        + "  [M to merge]", 10, y);
     y += 18;
 
     ofDrawBitmapString("Webcam: "
@@ -228,10 +354,59 @@ void ofApp::drawUI() {
         y += 18;
     }
 
+    int oversample = particleSystem.getOversampling(OscType::SAW);
+    ofDrawBitmapString("Oversampling: "
+        + (oversample > 1 ? ofToString(oversample) + "x (square + saw)" : std::string("OFF"))
+        + "  [Z to cycle]", 10, y);
+    y += 18;
+
+    ConvolutionReverb& reverb = synth.getReverb();
+    if (reverb.isLoaded()) {
+        ofDrawBitmapString("Reverb: "
+            + std::string(reverb.isEnabled() ? "ON" : "OFF")
+            + "  (" + ofToString(reverb.getIRSeconds(), 1) + "s IR"
+            + ", tail misses: " + ofToString(reverb.getTailMisses())
+            + ")  [V to toggle]", 10, y);
+        y += 18;
+    }
+
+    AudioRecorder& rec = synth.getRecorder();
+    if (rec.isRecording()) {
+        ofSetColor(255, 60, 60);
+        ofDrawBitmapString("REC " + ofToString(rec.getRecordedSeconds(), 1) + "s"
+            + "  overflows: " + ofToString(rec.getOverflowCount())
+            + (rec.hasWriteError() ? "  WRITE FAILED" : "")
+            + "  [R to stop]", 10, y);
+        ofSetColor(255);
+        y += 18;
+    }
+
+    if (inputAnalyzer.isEnabled()) {
+        std::string source = inputAnalyzer.hasFileSource() ? "FILE"
+                           : hasAudioInput ? "MIC" : "no input device";
+        ofDrawBitmapString("Input: " + source
+            + "  onsets: " + ofToString(inputAnalyzer.getOnsetCount())
+            + "  last pitch: " + ofToString(inputAnalyzer.getLastPitch(), 1) + " Hz"
+            + "  [I to stop]", 10, y);
+        y += 18;
+    }
+
+    if (Trace::isEnabled()) {
+        ofDrawBitmapString("Tracing ON  [x = export, X = stop]", 10, y);
+        y += 18;
+    }
+
+    // only shown in PARTICLESYNTH_RT_CHECK builds
+    if (RealtimeChecker::isEnabled()) {
+        ofDrawBitmapString("RT violations: "
+            + ofToString(RealtimeChecker::getViolationCount()), 10, y);
+        y += 18;
+    }
+
     ofSetColor(255, 80);
     int bottom = ofGetHeight() - 115;
     ofDrawBitmapString(
-        "KEYS: A-L = notes | W E T Y U O P = sharps | 1-4 = waveform | SPACE = clear",
+        "KEYS: A-L = notes | W E T Y U O P = sharps | 1-4 = waveform | SPACE = clear | R = record | M = merge | V = reverb | Z = oversample | I = input",
         10, bottom);
     ofDrawBitmapString(
         "MOUSE: click/drag = spawn | X-zone = waveform | Y = pitch",
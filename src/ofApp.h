@@ -3,6 +3,7 @@
 #include "ParticleSystem.h"
 #include "Synthesizer.h"
 #include "GestureTracker.h"
+#include "InputAnalyzer.h"
 #include <map>
 
 class ofApp : public ofBaseApp {
@@ -18,17 +19,25 @@ public:
     void mouseDragged(int x, int y, int button)  override;
 
     void audioOut(ofSoundBuffer& buffer);
+    void audioIn(ofSoundBuffer& buffer);
+
+    // play a WAV file into the input analysis instead of the mic. call before setup
+    void setInputFile(const std::string& path) { inputFilePath = path; }
 
 private:
     ParticleSystem  particleSystem;
     Synthesizer     synth;
     GestureTracker  gestureTracker;
+    InputAnalyzer   inputAnalyzer;
     ofSoundStream   soundStream;
 
-    OscType currentOscType = OscType::SINE;
+    OscType     currentOscType = OscType::SINE;
+    std::string inputFilePath;
+    bool        hasAudioInput = false;   // false if only an output stream could be opened
 
     void    spawnAtPosition(float x, float y);
     void    spawnAtPosition(float x, float y, OscType type);
+    void    spawnFromInput(const InputAnalyzer::Onset& onset);
     float   frequencyFromY(float y);      // screen Y -> Hz
     OscType oscTypeFromX(float x);        // screen zone -> waveform
     float   keyToFrequency(int key);      // keyboard key -> Hz (0 if not a note)